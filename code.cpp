@@ -11,99 +11,681 @@
 #include <cstdlib>
 #include <random>
 #include <cctype>
+#include <list>
+#include <unordered_map>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <thread>
+#include <condition_variable>
+#include <queue>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <array>
+#include <deque>
+#include <functional>
+
+#include "railway.h"
+
+#ifdef RAILWAY_HAS_SOCKETS
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
 // ==================== DATA STRUCTURES ====================
 
-class Train {
+// Heap bytes and allocation count of a structure, worked out from container
+// capacities when asked for, so nothing is counted on the hot path. Node and
+// bucket overheads follow libstdc++.
+struct MemoryUsage {
+    static const size_t NODE_LINKS = 2 * sizeof(void*);         // list / hash node
+    static const size_t TREE_NODE_LINKS = 4 * sizeof(void*);    // map node
+    static const size_t SHARED_CONTROL = 2 * sizeof(int) + sizeof(void*);
+
+    size_t bytes = 0;
+    size_t allocations = 0;
+
+    void addBlock(size_t size) {
+        if (size == 0) return;
+        bytes += size;
+        allocations++;
+    }
+
+    // Short strings live inside the string object
+    void add(const string& text) {
+        static const size_t inlineCapacity = string().capacity();
+        if (text.capacity() > inlineCapacity) addBlock(text.capacity() + 1);
+    }
+
+    template <typename T>
+    void add(const vector<T>& items) { addBlock(items.capacity() * sizeof(T)); }
+
+    template <typename T>
+    void add(const list<T>& items) {
+        for (size_t i = 0; i < items.size(); i++) addBlock(sizeof(T) + NODE_LINKS);
+    }
+
+    template <typename K, typename V>
+    void add(const map<K, V>& items) {
+        for (size_t i = 0; i < items.size(); i++) {
+            addBlock(sizeof(typename map<K, V>::value_type) + TREE_NODE_LINKS);
+        }
+    }
+
+    template <typename K, typename V>
+    void add(const unordered_map<K, V>& items) {
+        if (items.bucket_count() > 1) addBlock(items.bucket_count() * sizeof(void*));
+        for (size_t i = 0; i < items.size(); i++) {
+            addBlock(sizeof(typename unordered_map<K, V>::value_type) + NODE_LINKS);
+        }
+    }
+
+    MemoryUsage& operator+=(const MemoryUsage& other) {
+        bytes += other.bytes;
+        allocations += other.allocations;
+        return *this;
+    }
+};
+
+inline int countTrailingZeros(uint64_t word) { return __builtin_ctzll(word); }
+inline int popCount(uint64_t word) { return __builtin_popcountll(word); }
+
+// Free-seat bitmaps: 10 coaches of totalSeats/10 seats (one coach for very
+// small trains), one bit per seat, set = free. There is one bitmap per
+// station-to-station segment, so a seat left at a station can be sold
+// again for the rest of the route. Seats are numbered
+// coach * seatsPerCoach + position. Padding bits past the last seat of a
+// coach stay clear, so free-run scans stop at the coach boundary.
+// Segment ranges that are empty or off the route mean the whole run.
+class SeatMap {
 public:
-    string trainId;
-    string name;
-    string source;
-    string destination;
-    vector<string> stations;
-    vector<int> distances;
-    vector<vector<int>> seats;
-    int totalSeats;
-    string departureTime;
-    string arrivalTime;
-    double farePerKm;
-
-    Train(string id = "", string n = "", string src = "", string dest = "", int seatsCount = 0) {
-        trainId = id;
-        name = n;
-        source = src;
-        destination = dest;
-        totalSeats = seatsCount;
-        farePerKm = 2.5;
-        if (seatsCount > 0) {
-            seats.resize(10, vector<int>(seatsCount/10, 0));
+    int coaches;
+    int seatsPerCoach;
+    int wordsPerCoach;
+    int segments;
+    vector<uint64_t> freeBits;      // One coach-by-coach bitmap per segment
+
+    SeatMap(int totalSeats = 0, int segmentCount = 1) {
+        reset(totalSeats, segmentCount);
+    }
+
+    static int coachesFor(int totalSeats) {
+        if (totalSeats >= 10) return 10;
+        return totalSeats > 0 ? 1 : 0;
+    }
+
+    static int seatsPerCoachFor(int totalSeats) {
+        return totalSeats >= 10 ? totalSeats / 10 : max(0, totalSeats);
+    }
+
+    static int capacityFor(int totalSeats) {
+        return coachesFor(totalSeats) * seatsPerCoachFor(totalSeats);
+    }
+
+    // Human readable seat label, e.g. "C3-17"
+    static string seatLabel(int seat, int seatsPerCoach) {
+        if (seatsPerCoach <= 0) return to_string(seat + 1);
+        return "C" + to_string(seat / seatsPerCoach + 1) + "-" + to_string(seat % seatsPerCoach + 1);
+    }
+
+    // Mark every seat free again; keeps the bitmaps' allocation for reuse
+    void reset(int totalSeats, int segmentCount) {
+        coaches = coachesFor(totalSeats);
+        seatsPerCoach = seatsPerCoachFor(totalSeats);
+        wordsPerCoach = (seatsPerCoach + 63) / 64;
+        segments = max(1, segmentCount);
+        int words = coaches * wordsPerCoach;
+        freeBits.assign(segments * words, 0);
+        for (int c = 0; c < coaches; c++) {
+            for (int w = 0; w < wordsPerCoach; w++) {
+                int bits = min(64, seatsPerCoach - w * 64);
+                freeBits[c * wordsPerCoach + w] = bits == 64 ? ~0ULL : ((1ULL << bits) - 1);
+            }
+        }
+        for (int s = 1; s < segments; s++) {
+            copy(freeBits.begin(), freeBits.begin() + words, freeBits.begin() + s * words);
+        }
+    }
+
+    int capacity() const { return coaches * seatsPerCoach; }
+
+    // Seats free on every segment in [from, to)
+    int freeSeats(int from, int to) const {
+        int free = 0;
+        for (uint64_t word : freeOn(from, to)) free += popCount(word);
+        return free;
+    }
+
+    void occupy(int seat, int from, int to) {
+        if (seat < 0 || seat >= capacity()) return;
+        clampRange(from, to);
+        for (int s = from; s < to; s++) freeBits[wordIndex(s, seat)] &= ~(1ULL << (seat % seatsPerCoach % 64));
+    }
+
+    void release(int seat, int from, int to) {
+        if (seat < 0 || seat >= capacity()) return;
+        clampRange(from, to);
+        for (int s = from; s < to; s++) freeBits[wordIndex(s, seat)] |= 1ULL << (seat % seatsPerCoach % 64);
+    }
+
+    // Seat the group on segments [from, to), together if any coach has a
+    // long enough run of seats free on all of them (best fit: the shortest
+    // such run), otherwise split over as few coaches as possible. Returns
+    // false if there are not enough free seats.
+    bool allocate(int count, int from, int to, vector<int>& seatsOut) {
+        seatsOut.clear();
+        vector<uint64_t> free = freeOn(from, to);
+        int freeCount = 0;
+        for (uint64_t word : free) freeCount += popCount(word);
+        if (count <= 0 || freeCount < count) return false;
+
+        int bestCoach = -1, bestStart = 0, bestLength = 0;
+        for (int c = 0; c < coaches && bestLength != count; c++) {
+            int pos = 0;
+            while (pos < seatsPerCoach) {
+                int start = findNext(free, c, pos, true);
+                if (start >= seatsPerCoach) break;
+                int end = findNext(free, c, start, false);
+                int length = end - start;
+                if (length >= count && (bestCoach < 0 || length < bestLength)) {
+                    bestCoach = c;
+                    bestStart = start;
+                    bestLength = length;
+                    if (length == count) break;
+                }
+                pos = end;
+            }
+        }
+
+        if (bestCoach >= 0) {
+            for (int i = 0; i < count; i++) seatsOut.push_back(bestCoach * seatsPerCoach + bestStart + i);
+        } else {
+            // Fewest coaches: fill the emptiest coaches first
+            vector<pair<int, int>> byFree;
+            for (int c = 0; c < coaches; c++) byFree.push_back({-freeInCoach(free, c), c});
+            sort(byFree.begin(), byFree.end());
+
+            int remaining = count;
+            for (auto &entry : byFree) {
+                int c = entry.second;
+                for (int w = 0; w < wordsPerCoach && remaining > 0; w++) {
+                    uint64_t word = free[c * wordsPerCoach + w];
+                    while (word && remaining > 0) {
+                        seatsOut.push_back(c * seatsPerCoach + w * 64 + countTrailingZeros(word));
+                        word &= word - 1;
+                        remaining--;
+                    }
+                }
+                if (remaining == 0) break;
+            }
+        }
+
+        for (int seat : seatsOut) occupy(seat, from, to);
+        return true;
+    }
+
+private:
+    size_t wordIndex(int segment, int seat) const {
+        return ((size_t)segment * coaches + seat / seatsPerCoach) * wordsPerCoach + (seat % seatsPerCoach) / 64;
+    }
+
+    void clampRange(int& from, int& to) const {
+        if (from < 0 || to > segments || from >= to) {
+            from = 0;
+            to = segments;
+        }
+    }
+
+    // Seats free on every segment in [from, to), as one coach-by-coach bitmap
+    vector<uint64_t> freeOn(int from, int to) const {
+        clampRange(from, to);
+        size_t words = coaches * wordsPerCoach;
+        vector<uint64_t> free(freeBits.begin() + from * words, freeBits.begin() + (from + 1) * words);
+        for (int s = from + 1; s < to; s++) {
+            for (size_t w = 0; w < words; w++) free[w] &= freeBits[s * words + w];
+        }
+        return free;
+    }
+
+    int freeInCoach(const vector<uint64_t>& free, int coach) const {
+        int count = 0;
+        for (int w = 0; w < wordsPerCoach; w++) count += popCount(free[coach * wordsPerCoach + w]);
+        return count;
+    }
+
+    // First position >= from in the coach whose bit equals wantFree
+    int findNext(const vector<uint64_t>& free, int coach, int from, bool wantFree) const {
+        int wi = from / 64;
+        if (wi >= wordsPerCoach) return seatsPerCoach;
+        const uint64_t* words = &free[coach * wordsPerCoach];
+        uint64_t word = (wantFree ? words[wi] : ~words[wi]) & (~0ULL << (from % 64));
+        while (true) {
+            if (word) return min(seatsPerCoach, wi * 64 + countTrailingZeros(word));
+            if (++wi >= wordsPerCoach) return seatsPerCoach;
+            word = wantFree ? words[wi] : ~words[wi];
         }
     }
 };
 
-class Passenger {
+const char* mealPreferenceNames[] = {"None", "Veg", "Non-Veg"};
+
+// 0 unless text is 1-14 digits
+Pnr parsePnr(const string& text) {
+    if (text.empty() || text.size() > PNR_DIGITS) return 0;
+    Pnr pnr = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return 0;
+        pnr = pnr * 10 + (c - '0');
+    }
+    return pnr;
+}
+
+string formatPnr(Pnr pnr) {
+    char text[PNR_DIGITS + 1];
+    snprintf(text, sizeof(text), "%014llu", (unsigned long long)pnr);
+    return text;
+}
+
+// Contact and gender text written by older versions that the packed forms
+// cannot print back exactly ("98765 43210 ext 2", "Trans"). Records read
+// from data files and journals keep it here so saving them again loses
+// nothing; new input is still refused by parseContact / parseGender.
+class RawFieldTexts {
 public:
-    string name;
-    int age;
-    string gender;
-    string contact;
+    // Index of the text, adding it if new
+    size_t intern(const string& text) {
+        lock_guard<mutex> lock(mtx);    // bookings.dat is parsed on several threads
+        auto it = indexByText.find(text);
+        if (it != indexByText.end()) return it->second;
+        texts.push_back(text);
+        indexByText.emplace(text, texts.size() - 1);
+        return texts.size() - 1;
+    }
+
+    // Stays valid: texts are never removed and deque elements never move
+    const string& text(size_t index) {
+        lock_guard<mutex> lock(mtx);
+        return texts[index];
+    }
 
-    Passenger(string n = "", int a = 0, string g = "", string c = "") {
-        name = n;
-        age = a;
-        gender = g;
-        contact = c;
+    size_t size() {
+        lock_guard<mutex> lock(mtx);
+        return texts.size();
     }
+
+private:
+    mutex mtx;
+    deque<string> texts;
+    unordered_map<string, size_t> indexByText;
 };
 
-class Booking {
+RawFieldTexts rawContactTexts;
+RawFieldTexts rawGenderTexts;
+
+// A phone number packs into 64 bits: the digits after any leading zeros in
+// the low 60 bits, the number of leading zeros above them and a flag for a
+// leading '+', so "+91 ..." and "0471 ..." print back as entered. A zeros
+// count of 7 instead tags an index into rawContactTexts. 0 = none.
+const uint64_t CONTACT_PLUS = 1ULL << 63;
+const int CONTACT_ZEROS_SHIFT = 60;
+const uint64_t CONTACT_ZEROS_MASK = 7;
+const uint64_t CONTACT_RAW = CONTACT_ZEROS_MASK << CONTACT_ZEROS_SHIFT;
+const uint64_t CONTACT_DIGITS_MASK = (1ULL << CONTACT_ZEROS_SHIFT) - 1;
+const int MAX_CONTACT_DIGITS = 18;
+const int MAX_CONTACT_LEADING_ZEROS = 6;
+
+// False unless text is blank or an optional '+' then at most 18 digits (at
+// most 6 of them leading zeros). Spaces and dashes between digits are
+// dropped, so "98765 43210" and "9876543210" match.
+bool parseContact(const string& text, uint64_t& contact) {
+    contact = 0;
+    uint64_t number = 0, zeros = 0;
+    int digits = 0;
+    bool plus = false;
+    for (char c : text) {
+        if (c >= '0' && c <= '9') {
+            if (++digits > MAX_CONTACT_DIGITS) return false;
+            if (number == 0 && c == '0') {
+                if (++zeros > MAX_CONTACT_LEADING_ZEROS) return false;
+            } else {
+                number = number * 10 + (c - '0');
+            }
+        } else if (c == '+' && digits == 0 && !plus) {
+            plus = true;
+        } else if (c != ' ' && c != '-') {
+            return false;
+        }
+    }
+    if (digits == 0) return !plus;
+    contact = number | zeros << CONTACT_ZEROS_SHIFT | (plus ? CONTACT_PLUS : 0);
+    return true;
+}
+
+// Contact field of a stored record: as parseContact, but text it refuses is
+// kept verbatim
+uint64_t loadContact(const string& text) {
+    uint64_t contact;
+    if (parseContact(text, contact)) return contact;
+    return CONTACT_RAW | rawContactTexts.intern(text);
+}
+
+string formatContact(uint64_t contact) {
+    if (!contact) return "";
+    if ((contact & ~CONTACT_DIGITS_MASK) == CONTACT_RAW) return rawContactTexts.text(contact & CONTACT_DIGITS_MASK);
+    string text = (contact & CONTACT_PLUS) ? "+" : "";
+    text.append((contact >> CONTACT_ZEROS_SHIFT) & CONTACT_ZEROS_MASK, '0');
+    uint64_t number = contact & CONTACT_DIGITS_MASK;
+    if (number) text += to_string(number);
+    return text;
+}
+
+// False unless text is blank, "-", or M/F/O or Male/Female/Other in any case
+bool parseGender(const string& text, Gender& gender) {
+    size_t start = text.find_first_not_of(" \t");
+    string word = start == string::npos ? "" : text.substr(start, text.find_last_not_of(" \t") - start + 1);
+    for (char& c : word) c = (char)toupper((unsigned char)c);
+    if (word.empty() || word == "-") gender = GENDER_UNSPECIFIED;
+    else if (word == "M" || word == "MALE") gender = GENDER_MALE;
+    else if (word == "F" || word == "FEMALE") gender = GENDER_FEMALE;
+    else if (word == "O" || word == "OTHER") gender = GENDER_OTHER;
+    else return false;
+    return true;
+}
+
+// Gender values past GENDER_OTHER index rawGenderTexts
+const int GENDER_RAW_FIRST = GENDER_OTHER + 1;
+
+// Gender field of a stored record: as parseGender, but text it refuses is
+// kept verbatim. False only once 251 distinct such texts are in use.
+bool loadGender(const string& text, Gender& gender) {
+    if (parseGender(text, gender)) return true;
+    size_t index = rawGenderTexts.intern(text);
+    if (index > UINT8_MAX - GENDER_RAW_FIRST) return false;
+    gender = (Gender)(GENDER_RAW_FIRST + index);
+    return true;
+}
+
+const char* formatGender(Gender gender) {
+    static const char* names[] = {"-", "M", "F", "O"};
+    if (gender >= GENDER_RAW_FIRST) return rawGenderTexts.text(gender - GENDER_RAW_FIRST).c_str();
+    return names[gender];
+}
+
+bool parseBookingStatus(const string& text, BookingStatus& status) {
+    for (int i = BOOKING_CONFIRMED; i <= BOOKING_CANCELLED; i++) {
+        if (text == formatBookingStatus((BookingStatus)i)) {
+            status = (BookingStatus)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* formatBookingStatus(BookingStatus status) {
+    static const char* names[] = {"Confirmed", "Waitlisted", "Cancelled"};
+    return names[status];
+}
+
+// Older files can hold catering orders after the preference ("Veg, Veg (2x
+// Dal Rice)"); only an exact leading "Veg" / "Non-Veg" counts
+MealPreference parseMealPreference(const string& text) {
+    string preference = text.substr(0, text.find(", "));
+    if (preference == "Veg") return MEAL_PREF_VEG;
+    if (preference == "Non-Veg") return MEAL_PREF_NON_VEG;
+    return MEAL_PREF_NONE;
+}
+
+const char* mealTypeNames[MEAL_TYPE_COUNT] = {"Veg", "Non-Veg", "Beverage", "Snack"};
+
+// MealType for a type name, or -1
+int mealTypeIndex(const string& type) {
+    for (int t = 0; t < MEAL_TYPE_COUNT; t++) {
+        if (type == mealTypeNames[t]) return t;
+    }
+    return -1;
+}
+
+// MealType served for a booked preference, or -1
+int preferenceMealType(MealPreference preference) {
+    if (preference == MEAL_PREF_VEG) return MEAL_VEG;
+    if (preference == MEAL_PREF_NON_VEG) return MEAL_NON_VEG;
+    return -1;
+}
+
+// Append-mostly table stored in fixed-size chunks that are shared copy-on-write.
+// snapshot() copies only the chunk pointers; a chunk is cloned the first time
+// it is modified while a snapshot still references it. Elements are read-only
+// through iteration and operator[]; use mutate() to change one in place.
+template <typename T>
+class CowTable {
 public:
-    string pnr;
-    string trainId;
-    string source;
-    string destination;
-    vector<Passenger> passengers;
-    string date;
-    int coach;
-    vector<int> seatNumbers;
-    string status;
-    double fare;
-    string mealPreference;
+    static const size_t CHUNK_SIZE = 512;
+    typedef vector<T> Chunk;
+
+    template <typename ChunkPtr>
+    class Iterator {
+    public:
+        Iterator(const vector<ChunkPtr>* c, size_t i) : chunks(c), index(i) {}
+        const T& operator*() const { return (*(*chunks)[index / CHUNK_SIZE])[index % CHUNK_SIZE]; }
+        const T* operator->() const { return &**this; }
+        Iterator& operator++() { index++; return *this; }
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+        bool operator==(const Iterator& other) const { return index == other.index; }
+
+    private:
+        const vector<ChunkPtr>* chunks;
+        size_t index;
+    };
+
+    // Immutable point-in-time view, safe to read from another thread
+    class Snapshot {
+    public:
+        typedef Iterator<shared_ptr<const Chunk>> const_iterator;
+
+        Snapshot() : count(0) {}
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        const T& operator[](size_t i) const { return (*chunks[i / CHUNK_SIZE])[i % CHUNK_SIZE]; }
+        const_iterator begin() const { return const_iterator(&chunks, 0); }
+        const_iterator end() const { return const_iterator(&chunks, count); }
+
+    private:
+        friend class CowTable;
+        vector<shared_ptr<const Chunk>> chunks;
+        size_t count;
+    };
+
+    typedef Iterator<shared_ptr<Chunk>> const_iterator;
+
+    CowTable() : count(0), modifications(0) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Changes on every write, so readers can tell whether a snapshot is current
+    uint64_t version() const { return modifications; }
+
+    void clear() {
+        chunks.clear();
+        count = 0;
+        modifications++;
+    }
+
+    void push_back(const T& item) {
+        if (count % CHUNK_SIZE == 0) {
+            chunks.push_back(make_shared<Chunk>());
+            chunks.back()->reserve(CHUNK_SIZE);
+        }
+        writableChunk(chunks.size() - 1).push_back(item);
+        count++;
+        modifications++;
+    }
+
+    void assign(vector<T>&& items) {
+        clear();
+        for (auto &item : items) {
+            if (count % CHUNK_SIZE == 0) {
+                chunks.push_back(make_shared<Chunk>());
+                chunks.back()->reserve(CHUNK_SIZE);
+            }
+            chunks.back()->push_back(move(item));
+            count++;
+        }
+        modifications++;
+    }
+
+    const T& operator[](size_t i) const { return (*chunks[i / CHUNK_SIZE])[i % CHUNK_SIZE]; }
+
+    T& mutate(size_t i) {
+        modifications++;
+        return writableChunk(i / CHUNK_SIZE)[i % CHUNK_SIZE];
+    }
 
-    Booking(string tid = "", string src = "", string dest = "") {
-        trainId = tid;
-        source = src;
-        destination = dest;
-        status = "Confirmed";
-        fare = 0.0;
-        mealPreference = "None";
+    const_iterator begin() const { return const_iterator(&chunks, 0); }
+    const_iterator end() const { return const_iterator(&chunks, count); }
+
+    Snapshot snapshot() const {
+        Snapshot snap;
+        snap.chunks.assign(chunks.begin(), chunks.end());
+        snap.count = count;
+        return snap;
+    }
+
+    // The table's own storage; heap owned by the elements is not included
+    void accountMemory(MemoryUsage& usage) const {
+        usage.add(chunks);
+        for (auto &chunk : chunks) {
+            usage.addBlock(sizeof(Chunk) + MemoryUsage::SHARED_CONTROL);
+            usage.add(*chunk);
+        }
+    }
+
+private:
+    vector<shared_ptr<Chunk>> chunks;
+    size_t count;
+    uint64_t modifications;
+
+    Chunk& writableChunk(size_t c) {
+        if (chunks[c].use_count() > 1) {
+            chunks[c] = make_shared<Chunk>(*chunks[c]);
+        } else {
+            // Pairs with the release in the last snapshot's reference drop
+            atomic_thread_fence(memory_order_acquire);
+        }
+        return *chunks[c];
     }
 };
 
-class CateringItem {
+// One catering order; slots index bookings and cateringMenu
+struct CateringOrderLine {
+    uint32_t bookingSlot;
+    uint32_t itemSlot;
+    int32_t quantity;
+    double price;       // per item, at the time of ordering
+};
+
+// Append-only table of order lines in fixed-size blocks. Written lines never
+// move or change, so a snapshot is the block pointers plus a count, and
+// appends can continue while another thread reads it. Blocks dropped by
+// clear() are kept for reuse. The live table also indexes its lines by
+// booking; snapshots are only ever scanned whole.
+class CateringLedger {
 public:
-    string itemId;
-    string name;
-    string type;
-    double price;
-    int quantity;
-
-    CateringItem(string id = "", string n = "", string t = "", double p = 0.0, int q = 0) {
-        itemId = id;
-        name = n;
-        type = t;
-        price = p;
-        quantity = q;
+    static const size_t BLOCK_SIZE = 1024;
+    typedef array<CateringOrderLine, BLOCK_SIZE> Block;
+
+    class Snapshot {
+    public:
+        Snapshot() : count(0) {}
+        size_t size() const { return count; }
+        const CateringOrderLine& operator[](size_t i) const { return (*blocks[i / BLOCK_SIZE])[i % BLOCK_SIZE]; }
+
+    private:
+        friend class CateringLedger;
+        vector<shared_ptr<const Block>> blocks;
+        size_t count;
+    };
+
+    CateringLedger() : count(0) {}
+
+    size_t size() const { return count; }
+    const CateringOrderLine& operator[](size_t i) const { return (*blocks[i / BLOCK_SIZE])[i % BLOCK_SIZE]; }
+
+    void append(const CateringOrderLine& line) {
+        if (count % BLOCK_SIZE == 0) {
+            if (spare.empty()) {
+                blocks.push_back(make_shared<Block>());
+            } else {
+                blocks.push_back(spare.back());
+                spare.pop_back();
+            }
+        }
+        (*blocks.back())[count % BLOCK_SIZE] = line;
+        linesByBooking[line.bookingSlot].push_back((uint32_t)count);
+        count++;
+    }
+
+    void clear() {
+        for (auto &block : blocks) {
+            if (block.use_count() == 1) spare.push_back(block);
+        }
+        blocks.clear();
+        linesByBooking.clear();
+        count = 0;
+    }
+
+    // Calls fn(line) for each order of the booking, oldest first
+    template <typename Fn>
+    void forBooking(size_t bookingSlot, Fn fn) const {
+        auto it = linesByBooking.find((uint32_t)bookingSlot);
+        if (it == linesByBooking.end()) return;
+        for (uint32_t i : it->second) fn((*this)[i]);
+    }
+
+    Snapshot snapshot() const {
+        Snapshot snap;
+        snap.blocks.assign(blocks.begin(), blocks.end());
+        snap.count = count;
+        return snap;
+    }
+
+    void accountMemory(MemoryUsage& usage) const {
+        usage.add(blocks);
+        usage.add(spare);
+        for (size_t i = 0; i < blocks.size() + spare.size(); i++) {
+            usage.addBlock(sizeof(Block) + MemoryUsage::SHARED_CONTROL);
+        }
+        usage.add(linesByBooking);
+        for (auto &entry : linesByBooking) usage.add(entry.second);
     }
+
+private:
+    vector<shared_ptr<Block>> blocks;
+    vector<shared_ptr<Block>> spare;
+    unordered_map<uint32_t, vector<uint32_t>> linesByBooking;   // booking slot -> line positions
+    size_t count;
 };
 
 // ==================== GLOBAL VARIABLES ====================
 vector<Train> trains;
-vector<Booking> bookings;
+CowTable<Booking> bookings;
 vector<CateringItem> cateringMenu;
 map<string, int> pantryInventory;
+int pantryByType[MEAL_TYPE_COUNT] = {};   // pantryInventory summed per meal type
+CateringLedger cateringLedger;
+
+// Guards all of the above when the engine is driven from several threads
+// (replay load generator). The interactive console is single-threaded.
+mutex engineMutex;
 
 // ==================== HELPER FUNCTIONS ====================
 
@@ -131,1332 +713,4683 @@ bool isDouble(const string& str) {
     return true;
 }
 
-// ==================== PNR GENERATION ====================
+// ==================== LATENCY INSTRUMENTATION ====================
 
-string generatePNR(const string& travelDate = "") {
-    time_t now = time(0);
-    tm *ltm = localtime(&now);
+const char* operationNames[OP_COUNT] = {
+    "booking", "pnr_lookup", "route_search", "catering_order", "save_to_file", "load_from_file"
+};
 
-    // Get raw system time
-    int hour = ltm->tm_hour;
-    int minute = ltm->tm_min;
-    int second = ltm->tm_sec;
+// HDR-style log-linear histogram of nanosecond latencies: every power of two
+// is split into 16 linear sub-buckets, so any value is within ~6% of its bucket.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
 
-    // TIMEZONE ADJUSTMENT FOR INDIA (IST = UTC+5:30)
-    // If system shows 13:51 but actual is 19:21, uncomment these lines:
-    bool adjustForIST = true; // Set to true to convert UTC to IST
+    // Each histogram has a single writer thread; readers may merge concurrently
+    atomic<uint64_t> counts[BUCKET_COUNT];
 
-    if (adjustForIST) {
-        // Add 5 hours 30 minutes for Indian Standard Time
-        hour += 5;
-        minute += 30;
+    LatencyHistogram() {
+        for (int i = 0; i < BUCKET_COUNT; i++) counts[i].store(0, memory_order_relaxed);
+    }
 
-        // Handle overflow
-        if (minute >= 60) {
-            minute -= 60;
-            hour += 1;
+    void record(uint64_t nanos) {
+        atomic<uint64_t>& slot = counts[bucketFor(nanos)];
+        slot.store(slot.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    }
+
+    static int bucketFor(uint64_t value) {
+        if (value < (uint64_t)SUB_BUCKETS) return (int)value;
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + (int)((value >> shift) - SUB_BUCKETS);
+    }
+
+    // Highest value that falls into the bucket
+    static uint64_t bucketUpperBound(int index) {
+        if (index < SUB_BUCKETS) return index;
+        int shift = index / SUB_BUCKETS - 1;
+        uint64_t top = (uint64_t)(index % SUB_BUCKETS + SUB_BUCKETS);
+        return ((top + 1) << shift) - 1;
+    }
+};
+
+// Per-thread histograms, one per operation type. Threads register once and
+// then record without any locking; the stats screen merges all of them.
+class LatencyRegistry {
+public:
+    struct ThreadHistograms {
+        LatencyHistogram ops[OP_COUNT];
+    };
+
+    void record(OperationType op, uint64_t nanos) {
+        local().ops[op].record(nanos);
+    }
+
+    vector<uint64_t> merged(OperationType op) {
+        vector<uint64_t> total(LatencyHistogram::BUCKET_COUNT, 0);
+        lock_guard<mutex> lock(registryMutex);
+        for (auto &histograms : perThread) {
+            for (int i = 0; i < LatencyHistogram::BUCKET_COUNT; i++) {
+                total[i] += histograms->ops[op].counts[i].load(memory_order_relaxed);
+            }
         }
-        if (hour >= 24) {
-            hour -= 24;
+        return total;
+    }
+
+    static uint64_t totalCount(const vector<uint64_t>& buckets) {
+        uint64_t count = 0;
+        for (uint64_t c : buckets) count += c;
+        return count;
+    }
+
+    static uint64_t percentile(const vector<uint64_t>& buckets, double pct) {
+        uint64_t count = totalCount(buckets);
+        if (count == 0) return 0;
+        uint64_t rank = (uint64_t)(pct / 100.0 * count + 0.5);
+        if (rank < 1) rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+            if (seen >= rank) return LatencyHistogram::bucketUpperBound(i);
         }
+        return 0;
     }
 
-    // Get date from system
-    int pnrDay = ltm->tm_mday;
-    int pnrMonth = ltm->tm_mon + 1;
-    int pnrYear = ltm->tm_year + 1900;
+private:
+    mutex registryMutex;
+    vector<unique_ptr<ThreadHistograms>> perThread;   // Kept until exit so late merges stay valid
 
-    // Use travel date if provided (overrides system date)
-    if (!travelDate.empty() && travelDate.length() == 10 && 
-        travelDate[2] == '-' && travelDate[5] == '-') {
+    ThreadHistograms& local() {
+        // A thread may record into more than one registry (engine + replay)
+        thread_local vector<pair<LatencyRegistry*, ThreadHistograms*>> owned;
+        for (auto &entry : owned) {
+            if (entry.first == this) return *entry.second;
+        }
 
-        string dayStr = travelDate.substr(0, 2);
-        string monthStr = travelDate.substr(3, 2);
-        string yearStr = travelDate.substr(6, 4);
+        lock_guard<mutex> lock(registryMutex);
+        perThread.push_back(unique_ptr<ThreadHistograms>(new ThreadHistograms()));
+        owned.push_back({this, perThread.back().get()});
+        return *perThread.back();
+    }
+};
 
-        if (isNumber(dayStr) && isNumber(monthStr) && isNumber(yearStr)) {
-            pnrDay = stoi(dayStr);
-            pnrMonth = stoi(monthStr);
-            pnrYear = stoi(yearStr);
+LatencyRegistry latencyStats;
+
+uint64_t nowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Records the lifetime of a scope into the operation's histogram
+class ScopedLatency {
+public:
+    ScopedLatency(OperationType operation) {
+        op = operation;
+        start = nowNanos();
+    }
+
+    ~ScopedLatency() {
+        latencyStats.record(op, nowNanos() - start);
+    }
+
+private:
+    OperationType op;
+    uint64_t start;
+};
+
+OperationTimer::OperationTimer(OperationType operation) {
+    op = operation;
+    elapsed = 0;
+    start = nowNanos();
+    running = true;
+}
+
+void OperationTimer::pause() {
+    if (running) {
+        elapsed += nowNanos() - start;
+        running = false;
+    }
+}
+
+void OperationTimer::resume() {
+    if (!running) {
+        start = nowNanos();
+        running = true;
+    }
+}
+
+void OperationTimer::finish() {
+    pause();
+    latencyStats.record(op, elapsed);
+}
+
+void printLatencyStats(LatencyRegistry& registry = latencyStats) {
+    cout << "\nOperation latency (microseconds):\n";
+    cout << left << setw(18) << "Operation"
+         << setw(10) << "Count"
+         << setw(12) << "p50"
+         << setw(12) << "p99"
+         << setw(12) << "p99.9"
+         << endl;
+    cout << string(64, '-') << endl;
+
+    for (int op = 0; op < OP_COUNT; op++) {
+        vector<uint64_t> buckets = registry.merged((OperationType)op);
+        cout << left << setw(18) << operationNames[op]
+             << setw(10) << LatencyRegistry::totalCount(buckets)
+             << fixed << setprecision(1)
+             << setw(12) << LatencyRegistry::percentile(buckets, 50.0) / 1000.0
+             << setw(12) << LatencyRegistry::percentile(buckets, 99.0) / 1000.0
+             << setw(12) << LatencyRegistry::percentile(buckets, 99.9) / 1000.0
+             << endl;
+    }
+}
+
+// Writes non-empty buckets as: operation|bucketUpperBoundNs|count
+bool dumpLatencyHistograms(const string& filename) {
+    ofstream out(filename);
+    if (!out.is_open()) return false;
+
+    for (int op = 0; op < OP_COUNT; op++) {
+        vector<uint64_t> buckets = latencyStats.merged((OperationType)op);
+        for (size_t i = 0; i < buckets.size(); i++) {
+            if (buckets[i] > 0) {
+                out << operationNames[op] << "|" << LatencyHistogram::bucketUpperBound(i)
+                    << "|" << buckets[i] << "\n";
+            }
         }
     }
+    return true;
+}
 
-    // Generate PNR: HHMMSSDDMMYYYY
-    stringstream ss;
-    ss << setfill('0') 
-       << setw(2) << hour        // Hour (24-hour format, adjusted for IST)
-       << setw(2) << minute      // Minute
-       << setw(2) << second      // Second
-       << setw(2) << pnrDay      // Day (from travel date or current)
-       << setw(2) << pnrMonth    // Month (from travel date or current)
-       << pnrYear;               // Year (from travel date or current)
+// ==================== TRACING ====================
+
+struct TraceEvent {
+    const char* name;
+    uint64_t startNanos;
+    uint64_t durationNanos;
+};
+
+// Single-producer ring buffer owned by one thread. The owner publishes each
+// event with a release store of head; the writer reads up to an acquired head.
+class TraceRing {
+public:
+    static const size_t CAPACITY = 1 << 14;
+
+    TraceEvent events[CAPACITY];
+    atomic<uint64_t> head;
+    int threadId;
+
+    TraceRing(int tid) {
+        head.store(0, memory_order_relaxed);
+        threadId = tid;
+    }
+
+    void push(const TraceEvent& event) {
+        uint64_t h = head.load(memory_order_relaxed);
+        events[h & (CAPACITY - 1)] = event;
+        head.store(h + 1, memory_order_release);
+    }
+};
+
+// Opt-in span tracer writing Chrome trace-event JSON (chrome://tracing, Perfetto).
+// When disabled a span costs one relaxed load.
+class Tracer {
+public:
+    Tracer() {
+        enabled.store(false, memory_order_relaxed);
+        epochNanos = 0;
+    }
+
+    void enable(const string& path) {
+        outputPath = path;
+        epochNanos = nowNanos();
+        enabled.store(true, memory_order_release);
+    }
+
+    bool isEnabled() const {
+        return enabled.load(memory_order_relaxed);
+    }
+
+    const string& path() const { return outputPath; }
+
+    void record(const char* name, uint64_t start, uint64_t duration) {
+        local().push({name, start, duration});
+    }
+
+    bool writeChromeTrace() {
+        ofstream out(outputPath);
+        if (!out.is_open()) return false;
+
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        lock_guard<mutex> lock(registryMutex);
+        for (auto &ring : rings) {
+            uint64_t end = ring->head.load(memory_order_acquire);
+            uint64_t begin = end > TraceRing::CAPACITY ? end - TraceRing::CAPACITY : 0;
+            for (uint64_t i = begin; i < end; i++) {
+                const TraceEvent& e = ring->events[i & (TraceRing::CAPACITY - 1)];
+                out << (first ? "\n" : ",\n")
+                    << "{\"name\":\"" << e.name << "\",\"cat\":\"railway\",\"ph\":\"X\""
+                    << ",\"ts\":" << fixed << setprecision(3) << (e.startNanos - epochNanos) / 1000.0
+                    << ",\"dur\":" << e.durationNanos / 1000.0
+                    << ",\"pid\":1,\"tid\":" << ring->threadId << "}";
+                first = false;
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return true;
+    }
+
+private:
+    atomic<bool> enabled;
+    string outputPath;
+    uint64_t epochNanos;
+    mutex registryMutex;
+    vector<unique_ptr<TraceRing>> rings;
+
+    TraceRing& local() {
+        thread_local TraceRing* ring = nullptr;
+        if (!ring) {
+            lock_guard<mutex> lock(registryMutex);
+            rings.push_back(unique_ptr<TraceRing>(new TraceRing((int)rings.size() + 1)));
+            ring = rings.back().get();
+        }
+        return *ring;
+    }
+};
+
+Tracer tracer;
+
+void enableTracing(const string& path) { tracer.enable(path); }
+bool tracingEnabled() { return tracer.isEnabled(); }
+bool writeTrace() { return tracer.writeChromeTrace(); }
+string tracePath() { return tracer.path(); }
+
+TraceSpan::TraceSpan(const char* spanName) {
+    name = spanName;
+    start = tracer.isEnabled() ? nowNanos() : 0;
+}
+
+TraceSpan::~TraceSpan() {
+    if (start) tracer.record(name, start, nowNanos() - start);
+}
+
+// ==================== SESSION RECORDING ====================
+
+// Captures the operations a console session performs, one per line:
+//   <offset in microseconds>|<operation>|<fields...>
+// Operations: BOOK, PNR, CATER, ROUTE, CANCEL. Replayed with --replay.
+class SessionRecorder {
+public:
+    bool enable(const string& path) {
+        out.open(path);
+        startNanos = nowNanos();
+        return out.is_open();
+    }
+
+    bool isEnabled() const { return out.is_open(); }
+
+    void record(const string& operation, const vector<string>& fields) {
+        if (!out.is_open()) return;
+        out << (nowNanos() - startNanos) / 1000 << "|" << operation;
+        for (const auto& field : fields) {
+            out << "|" << field;
+        }
+        out << "\n";
+        out.flush();
+    }
+
+    void recordBooking(const Booking& booking) {
+        if (!out.is_open()) return;
+        vector<string> fields = {formatPnr(booking.pnr), booking.trainId, booking.source,
+                                 booking.destination, booking.date,
+                                 mealPreferenceNames[booking.mealPreference],
+                                 to_string(booking.passengers.size())};
+        for (auto &passenger : booking.passengers) {
+            fields.push_back(passenger.name);
+            fields.push_back(to_string(passenger.age));
+            fields.push_back(formatGender(passenger.gender));
+            fields.push_back(formatContact(passenger.contact));
+        }
+        record("BOOK", fields);
+    }
+
+private:
+    ofstream out;
+    uint64_t startNanos;
+};
+
+SessionRecorder sessionRecorder;
+
+bool enableSessionRecording(const string& path) { return sessionRecorder.enable(path); }
+
+void recordSession(const string& operation, const vector<string>& fields) {
+    sessionRecorder.record(operation, fields);
+}
+
+void recordSessionBooking(const Booking& booking) { sessionRecorder.recordBooking(booking); }
+
+// ==================== PNR GENERATION ====================
+
+string generatePNR(const string& travelDate = "") {
+    time_t now = time(0);
+    tm *ltm = localtime(&now);
+
+    // Get raw system time
+    int hour = ltm->tm_hour;
+    int minute = ltm->tm_min;
+    int second = ltm->tm_sec;
+
+    // TIMEZONE ADJUSTMENT FOR INDIA (IST = UTC+5:30)
+    // If system shows 13:51 but actual is 19:21, uncomment these lines:
+    bool adjustForIST = true; // Set to true to convert UTC to IST
+
+    if (adjustForIST) {
+        // Add 5 hours 30 minutes for Indian Standard Time
+        hour += 5;
+        minute += 30;
+
+        // Handle overflow
+        if (minute >= 60) {
+            minute -= 60;
+            hour += 1;
+        }
+        if (hour >= 24) {
+            hour -= 24;
+        }
+    }
+
+    // Get date from system
+    int pnrDay = ltm->tm_mday;
+    int pnrMonth = ltm->tm_mon + 1;
+    int pnrYear = ltm->tm_year + 1900;
+
+    // Use travel date if provided (overrides system date)
+    if (!travelDate.empty() && travelDate.length() == 10 && 
+        travelDate[2] == '-' && travelDate[5] == '-') {
+
+        string dayStr = travelDate.substr(0, 2);
+        string monthStr = travelDate.substr(3, 2);
+        string yearStr = travelDate.substr(6, 4);
+
+        if (isNumber(dayStr) && isNumber(monthStr) && isNumber(yearStr)) {
+            pnrDay = stoi(dayStr);
+            pnrMonth = stoi(monthStr);
+            pnrYear = stoi(yearStr);
+        }
+    }
+
+    // Generate PNR: HHMMSSDDMMYYYY
+    stringstream ss;
+    ss << setfill('0') 
+       << setw(2) << hour        // Hour (24-hour format, adjusted for IST)
+       << setw(2) << minute      // Minute
+       << setw(2) << second      // Second
+       << setw(2) << pnrDay      // Day (from travel date or current)
+       << setw(2) << pnrMonth    // Month (from travel date or current)
+       << pnrYear;               // Year (from travel date or current)
+
+    return ss.str();
+}
+
+// ==================== STATION DISTANCES ====================
+
+const int UNKNOWN_ROUTE_DISTANCE = 500;     // No train links the two stations
+const size_t PRECOMPUTE_STATION_LIMIT = 2048;
+const int32_t NO_ROUTE = -1;                // Matrix entry for unconnected stations
+
+// Shortest known distance between any two stations over the whole network.
+// Each train adds an edge between consecutive stops weighted by the
+// difference of their distances from its source (both directions). Matrix
+// rows are filled by one Dijkstra per source station, lazily or all at once
+// for small networks, and patched in place when a train is added, so a
+// lookup is O(1) once its row exists.
+class StationNetwork {
+public:
+    StationNetwork() { computedRows = 0; }
+
+    void clear() {
+        ids.clear();
+        names.clear();
+        adjacency.clear();
+        rows.clear();
+        computedRows = 0;
+    }
+
+    void rebuild(const vector<Train>& all) {
+        clear();
+        for (auto &train : all) addEdges(train);
+        if (names.size() <= PRECOMPUTE_STATION_LIMIT) precomputeAll(thread::hardware_concurrency());
+    }
+
+    // Returns true when a distance between stations already in the network
+    // got shorter (or known), so results derived from it are stale
+    bool addTrain(const Train& train) {
+        size_t knownStations = names.size();
+        vector<uint32_t> route = addEdges(train);
+        if (route.empty()) return false;
+        bool shortened = false;
+        for (auto &row : rows) {
+            if (!row.empty()) row.resize(names.size(), NO_ROUTE);
+        }
+
+        // A path that got shorter enters the new train at some stop x and
+        // reaches x over old edges only, so d'(s,t) = min(d(s,t), d(s,x) + d'(x,t))
+        vector<vector<int32_t>> fromRoute;
+        for (uint32_t stop : route) fromRoute.push_back(shortestFrom(stop));
+        for (auto &row : rows) {
+            if (row.empty()) continue;
+            vector<int32_t> toRoute;
+            for (uint32_t stop : route) toRoute.push_back(row[stop]);
+            for (size_t k = 0; k < route.size(); k++) {
+                if (toRoute[k] == NO_ROUTE) continue;
+                const vector<int32_t>& via = fromRoute[k];
+                for (size_t t = 0; t < via.size(); t++) {
+                    if (via[t] == NO_ROUTE) continue;
+                    int32_t km = toRoute[k] + via[t];
+                    if (row[t] == NO_ROUTE || km < row[t]) {
+                        row[t] = km;
+                        shortened = shortened || t < knownStations;
+                    }
+                }
+            }
+        }
+        for (size_t k = 0; k < route.size(); k++) {
+            if (rows[route[k]].empty()) computedRows++;
+            rows[route[k]] = move(fromRoute[k]);
+        }
+        return shortened;
+    }
+
+    // Distance in km, or NO_ROUTE when no chain of trains links them
+    int32_t distance(const string& from, const string& to) {
+        auto a = ids.find(from);
+        auto b = ids.find(to);
+        if (a == ids.end() || b == ids.end()) return NO_ROUTE;
+        vector<int32_t>& row = rows[a->second];
+        if (row.empty()) {
+            row = shortestFrom(a->second);
+            computedRows++;
+        }
+        return row[b->second];
+    }
+
+    // Fill every missing row; sources are independent, so they are shared
+    // out across threads
+    void precomputeAll(unsigned threadCount) {
+        vector<uint32_t> missing;
+        for (uint32_t s = 0; s < rows.size(); s++) {
+            if (rows[s].empty()) missing.push_back(s);
+        }
+        atomic<size_t> next(0);
+        auto work = [&]() {
+            for (size_t i = next++; i < missing.size(); i = next++) rows[missing[i]] = shortestFrom(missing[i]);
+        };
+        vector<thread> workers;
+        for (unsigned t = 1; t < max(1u, threadCount) && t < missing.size(); t++) workers.push_back(thread(work));
+        work();
+        for (auto &worker : workers) worker.join();
+        computedRows += missing.size();
+    }
+
+    size_t size() const { return names.size(); }
+    size_t rowsComputed() const { return computedRows; }
+
+    void accountMemory(MemoryUsage& usage) const {
+        usage.add(ids);
+        usage.add(names);
+        for (auto &name : names) usage.add(name);
+        usage.add(adjacency);
+        for (auto &edges : adjacency) usage.add(edges);
+        usage.add(rows);
+        for (auto &row : rows) usage.add(row);
+    }
+
+private:
+    unordered_map<string, uint32_t> ids;
+    vector<string> names;
+    vector<vector<pair<uint32_t, int32_t>>> adjacency;   // (station, km)
+    vector<vector<int32_t>> rows;                        // empty until computed
+    size_t computedRows;
+
+    uint32_t stationId(const string& name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        uint32_t id = names.size();
+        ids[name] = id;
+        names.push_back(name);
+        adjacency.emplace_back();
+        rows.emplace_back();
+        return id;
+    }
+
+    // Several trains can link the same two stops; keep the shorter edge
+    void link(uint32_t a, uint32_t b, int32_t km) {
+        for (auto &edge : adjacency[a]) {
+            if (edge.first == b) {
+                edge.second = min(edge.second, km);
+                return;
+            }
+        }
+        adjacency[a].push_back({b, km});
+    }
+
+    // The train's stops in order, or none when it carries no distances
+    vector<uint32_t> addEdges(const Train& train) {
+        if (train.stations.empty() || train.distances.size() != train.stations.size()) return {};
+        vector<uint32_t> route;
+        vector<int32_t> km;
+        route.push_back(stationId(train.source));
+        km.push_back(0);
+        for (size_t i = 0; i < train.stations.size(); i++) {
+            route.push_back(stationId(train.stations[i]));
+            km.push_back(train.distances[i]);
+        }
+        route.push_back(stationId(train.destination));
+        km.push_back(train.distances.back());
+        for (size_t i = 0; i + 1 < route.size(); i++) {
+            int32_t leg = max(0, km[i + 1] - km[i]);
+            link(route[i], route[i + 1], leg);
+            link(route[i + 1], route[i], leg);
+        }
+        return route;
+    }
+
+    vector<int32_t> shortestFrom(uint32_t source) const {
+        vector<int32_t> dist(names.size(), NO_ROUTE);
+        priority_queue<pair<int32_t, uint32_t>, vector<pair<int32_t, uint32_t>>,
+                       greater<pair<int32_t, uint32_t>>> frontier;
+        dist[source] = 0;
+        frontier.push({0, source});
+        while (!frontier.empty()) {
+            auto top = frontier.top();
+            frontier.pop();
+            if (top.first != dist[top.second]) continue;
+            for (auto &edge : adjacency[top.second]) {
+                int32_t km = top.first + edge.second;
+                if (dist[edge.first] == NO_ROUTE || km < dist[edge.first]) {
+                    dist[edge.first] = km;
+                    frontier.push({km, edge.first});
+                }
+            }
+        }
+        return dist;
+    }
+};
+
+StationNetwork stationNetwork;
+
+// Distance of stop p from the train's origin: 0 is the source, 1..n the
+// intermediate stations and n + 1 the destination, which is recorded at
+// the last station's distance
+int distanceFromOrigin(const Train& train, int pos) {
+    if (pos == 0) return 0;
+    if (pos <= (int)train.stations.size()) return train.distances[pos - 1];
+    return train.distances.back();
+}
+
+// Function to calculate distance between two stations on a route
+int calculateRouteDistance(Train* train, const string& source, const string& destination) {
+    // Find positions of source and destination
+    int sourcePos = -1, destPos = -1;
+
+    // Check if source is the starting station
+    if (source == train->source) {
+        sourcePos = 0;
+    }
+
+    // Check if destination is the ending station
+    if (destination == train->destination) {
+        destPos = train->stations.size() + 1;
+    }
+
+    // Check intermediate stations
+    for (int i = 0; i < train->stations.size(); i++) {
+        if (train->stations[i] == source) {
+            sourcePos = i + 1;
+        }
+        if (train->stations[i] == destination) {
+            destPos = i + 1;
+        }
+    }
+
+    // Along this train when it runs from source to destination
+    if (sourcePos >= 0 && destPos > sourcePos && !train->distances.empty()) {
+        return distanceFromOrigin(*train, destPos) - distanceFromOrigin(*train, sourcePos);
+    }
+
+    // Otherwise the shortest distance over the whole network
+    int32_t distance = stationNetwork.distance(source, destination);
+    return distance != NO_ROUTE ? distance : UNKNOWN_ROUTE_DISTANCE;
+}
+
+// ==================== ROUTE SEARCH CACHE ====================
+
+// Bounded LRU cache of route search results keyed by (source, destination).
+// Entries are dropped as soon as a train serving either station is added.
+class RouteSearchCache {
+public:
+    size_t hits;
+    size_t misses;
+
+    RouteSearchCache(size_t cap = 256) {
+        capacity = cap;
+        hits = 0;
+        misses = 0;
+    }
+
+    bool lookup(const string& source, const string& destination, vector<RouteOption>& result) {
+        auto it = index.find(makeKey(source, destination));
+        if (it == index.end()) {
+            misses++;
+            return false;
+        }
+        // Move to front (most recently used)
+        entries.splice(entries.begin(), entries, it->second);
+        result = it->second->options;
+        hits++;
+        return true;
+    }
+
+    void store(const string& source, const string& destination, const vector<RouteOption>& options) {
+        string key = makeKey(source, destination);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->options = options;
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+
+        entries.push_front({source, destination, options});
+        index[key] = entries.begin();
+
+        if (entries.size() > capacity) {
+            index.erase(makeKey(entries.back().source, entries.back().destination));
+            entries.pop_back();
+        }
+    }
+
+    // Drop every cached search whose source or destination is served by the train
+    void invalidateTrain(const Train& train) {
+        vector<string> served = train.stations;
+        served.push_back(train.source);
+        served.push_back(train.destination);
+
+        for (auto it = entries.begin(); it != entries.end(); ) {
+            bool touched = false;
+            for (const auto& station : served) {
+                if (it->source == station || it->destination == station) {
+                    touched = true;
+                    break;
+                }
+            }
+            if (touched) {
+                index.erase(makeKey(it->source, it->destination));
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void clear() {
+        entries.clear();
+        index.clear();
+    }
+
+    size_t size() const { return entries.size(); }
+    size_t maxSize() const { return capacity; }
+
+    void accountMemory(MemoryUsage& usage) const {
+        usage.add(entries);
+        for (auto &entry : entries) {
+            usage.add(entry.source);
+            usage.add(entry.destination);
+            usage.add(entry.options);
+        }
+        usage.add(index);
+        for (auto &entry : index) usage.add(entry.first);
+    }
+
+private:
+    struct Entry {
+        string source;
+        string destination;
+        vector<RouteOption> options;
+    };
+
+    size_t capacity;
+    list<Entry> entries;
+    unordered_map<string, list<Entry>::iterator> index;
+
+    static string makeKey(const string& source, const string& destination) {
+        return source + "|" + destination;
+    }
+};
+
+RouteSearchCache routeCache;
+
+// Find all trains serving source -> destination, sorted by fare (cached)
+vector<RouteOption> findRouteAlternatives(const string& source, const string& dest) {
+    ScopedLatency latency(OP_ROUTE_SEARCH);
+    TraceSpan span("findRouteAlternatives");
+    vector<RouteOption> alternatives;
+    if (routeCache.lookup(source, dest, alternatives)) {
+        return alternatives;
+    }
+
+    for (size_t i = 0; i < trains.size(); i++) {
+        Train& train = trains[i];
+        bool hasSource = false;
+        bool hasDest = false;
+
+        // Check source
+        if (train.source == source) hasSource = true;
+        if (train.destination == dest) hasDest = true;
+
+        // Check intermediate stations
+        for (const auto& station : train.stations) {
+            if (station == source) hasSource = true;
+            if (station == dest) hasDest = true;
+        }
+
+        if (hasSource && hasDest) {
+            // Calculate actual distance
+            int distance = calculateRouteDistance(&train, source, dest);
+            alternatives.push_back({distance * train.farePerKm, distance, i});
+        }
+    }
+
+    // Sort by fare
+    stable_sort(alternatives.begin(), alternatives.end(),
+                [](const RouteOption& a, const RouteOption& b) { return a.fare < b.fare; });
+
+    routeCache.store(source, dest, alternatives);
+    return alternatives;
+}
+
+// ==================== LOOKUPS ====================
+
+Train* findTrain(const string& trainId) {
+    for (auto &train : trains) {
+        if (train.trainId == trainId) return &train;
+    }
+    return nullptr;
+}
+
+// PNR -> booking slot. Older data files can contain a repeated PNR; the
+// first booking with it wins, as with the previous linear scan.
+unordered_map<Pnr, size_t> pnrIndex;
+
+// Passenger contact / name -> slots of the bookings they travel on
+unordered_map<uint64_t, vector<size_t>> contactIndex;
+unordered_map<string, vector<size_t>> nameIndex;
+
+// Lowercase with single spaces between words
+string normalizeName(const string& name) {
+    string result;
+    bool pendingSpace = false;
+    for (char c : name) {
+        if (isspace((unsigned char)c)) {
+            pendingSpace = !result.empty();
+        } else {
+            if (pendingSpace) result += ' ';
+            result += (char)tolower((unsigned char)c);
+            pendingSpace = false;
+        }
+    }
+    return result;
+}
+
+template <typename Key>
+void addToIndex(unordered_map<Key, vector<size_t>>& index, const Key& key, size_t slot) {
+    vector<size_t>& slots = index[key];
+    if (slots.empty() || slots.back() != slot) slots.push_back(slot);
+}
+
+void indexBooking(size_t slot) {
+    const Booking& booking = bookings[slot];
+    pnrIndex.emplace(booking.pnr, slot);
+    for (auto &passenger : booking.passengers) {
+        if (passenger.contact) addToIndex(contactIndex, passenger.contact, slot);
+        string name = normalizeName(passenger.name);
+        if (!name.empty()) addToIndex(nameIndex, name, slot);
+    }
+}
+
+void rebuildBookingIndexes() {
+    pnrIndex.clear();
+    contactIndex.clear();
+    nameIndex.clear();
+    for (size_t i = 0; i < bookings.size(); i++) indexBooking(i);
+}
+
+// Slots of all bookings with a passenger having this phone number
+vector<size_t> findBookingsByContact(const string& contact) {
+    uint64_t number;
+    if (!parseContact(contact, number)) return vector<size_t>();
+    auto it = contactIndex.find(number);
+    return it == contactIndex.end() ? vector<size_t>() : it->second;
+}
+
+// Slots of all bookings with a passenger having this name
+vector<size_t> findBookingsByName(const string& name) {
+    auto it = nameIndex.find(normalizeName(name));
+    return it == nameIndex.end() ? vector<size_t>() : it->second;
+}
+
+// Append to the bookings table and keep the indexes in step
+void appendBooking(const Booking& booking) {
+    bookings.push_back(booking);
+    indexBooking(bookings.size() - 1);
+}
+
+// Slot of the booking in the bookings table, or -1
+long findBookingIndex(const string& pnr) {
+    ScopedLatency latency(OP_PNR_LOOKUP);
+    auto it = pnrIndex.find(parsePnr(pnr));
+    return it == pnrIndex.end() ? -1 : (long)it->second;
+}
+
+const Booking* findBookingByPnr(const string& pnr) {
+    long index = findBookingIndex(pnr);
+    return index >= 0 ? &bookings[index] : nullptr;
+}
+
+CateringItem* findCateringItem(const string& itemId) {
+    for (auto &item : cateringMenu) {
+        if (item.itemId == itemId) return &item;
+    }
+    return nullptr;
+}
+
+// Keep the menu's quantity in step with the pantry
+void setPantryStock(const string& itemId, int quantity) {
+    int& stock = pantryInventory[itemId];
+    CateringItem* item = findCateringItem(itemId);
+    if (item) {
+        int type = mealTypeIndex(item->type);
+        if (type >= 0) pantryByType[type] += quantity - stock;
+        item->quantity = quantity;
+    }
+    stock = quantity;
+}
+
+void recordCateringOrder(size_t bookingSlot, const CateringItem& item, int quantity) {
+    uint32_t itemSlot = &item - cateringMenu.data();
+    cateringLedger.append({(uint32_t)bookingSlot, itemSlot, quantity, item.price});
+}
+
+// Undo the booking's catering orders when it is cancelled: the ledger gets
+// a negative line for each order and the pantry its stock back. Journal
+// replay repeats this for each half its data file does not yet contain.
+// Returns the amount refunded.
+double reverseCateringOrders(size_t bookingSlot, bool reverseLines, bool restock) {
+    vector<CateringOrderLine> orders;
+    cateringLedger.forBooking(bookingSlot, [&](const CateringOrderLine& line) {
+        if (line.quantity > 0) orders.push_back(line);
+    });
+    double amount = 0.0;
+    for (auto &line : orders) {
+        if (reverseLines) cateringLedger.append({line.bookingSlot, line.itemSlot, -line.quantity, line.price});
+        if (restock) {
+            const string& itemId = cateringMenu[line.itemSlot].itemId;
+            setPantryStock(itemId, pantryInventory[itemId] + line.quantity);
+        }
+        amount += line.price * line.quantity;
+    }
+    return amount;
+}
+
+// Total of the booking's catering orders
+double cateringBill(size_t bookingSlot) {
+    double total = 0.0;
+    cateringLedger.forBooking(bookingSlot, [&](const CateringOrderLine& line) {
+        total += line.price * line.quantity;
+    });
+    return total;
+}
+
+// ==================== STATION DICTIONARY ====================
+
+string lowercase(const string& text) {
+    string result = text;
+    transform(result.begin(), result.end(), result.begin(), ::tolower);
+    return result;
+}
+
+// Levenshtein distance, giving up early once every cell exceeds maxDistance
+int editDistance(const string& a, const string& b, int maxDistance) {
+    int n = a.size(), m = b.size();
+    if (abs(n - m) > maxDistance) return maxDistance + 1;
+    vector<int> prev(m + 1), curr(m + 1);
+    for (int j = 0; j <= m; j++) prev[j] = j;
+    for (int i = 1; i <= n; i++) {
+        curr[0] = i;
+        int rowMin = curr[0];
+        for (int j = 1; j <= m; j++) {
+            int cost = (a[i - 1] == b[j - 1]) ? 0 : 1;
+            curr[j] = min({prev[j] + 1, curr[j - 1] + 1, prev[j - 1] + cost});
+            rowMin = min(rowMin, curr[j]);
+        }
+        if (rowMin > maxDistance) return maxDistance + 1;
+        swap(prev, curr);
+    }
+    return prev[m];
+}
+
+// All station names seen on any train. A prefix trie answers autocomplete
+// and a BK-tree answers "did you mean" lookups; both work on lowercase keys.
+class StationDictionary {
+    struct TrieNode {
+        vector<pair<char, int>> next;   // sorted by character
+        int station = -1;
+    };
+    struct BkNode {
+        int station;
+        vector<pair<int, int>> children; // (edit distance, node)
+    };
+
+    vector<string> names;               // canonical spelling
+    vector<string> keys;                // lowercase spelling
+    unordered_map<string, int> byKey;
+    vector<TrieNode> trie;
+    vector<BkNode> bkTree;
+
+    int child(int node, char c) const {
+        const auto& next = trie[node].next;
+        auto it = lower_bound(next.begin(), next.end(), make_pair(c, -1));
+        return (it != next.end() && it->first == c) ? it->second : -1;
+    }
+
+    void collect(int node, size_t limit, vector<string>& out) const {
+        if (out.size() >= limit) return;
+        if (trie[node].station >= 0) out.push_back(names[trie[node].station]);
+        for (auto &edge : trie[node].next) {
+            if (out.size() >= limit) return;
+            collect(edge.second, limit, out);
+        }
+    }
+
+public:
+    StationDictionary() { clear(); }
+
+    void clear() {
+        names.clear();
+        keys.clear();
+        byKey.clear();
+        trie.assign(1, TrieNode());
+        bkTree.clear();
+    }
+
+    size_t size() const { return names.size(); }
+
+    void accountMemory(MemoryUsage& usage) const {
+        usage.add(names);
+        usage.add(keys);
+        for (size_t i = 0; i < names.size(); i++) {
+            usage.add(names[i]);
+            usage.add(keys[i]);
+        }
+        usage.add(byKey);
+        for (auto &entry : byKey) usage.add(entry.first);
+        usage.add(trie);
+        for (auto &node : trie) usage.add(node.next);
+        usage.add(bkTree);
+        for (auto &node : bkTree) usage.add(node.children);
+    }
+
+    void add(const string& name) {
+        if (name.empty()) return;
+        string key = lowercase(name);
+        if (byKey.count(key)) return;
+        int id = names.size();
+        names.push_back(name);
+        keys.push_back(key);
+        byKey[key] = id;
+
+        int node = 0;
+        for (char c : key) {
+            int nextNode = child(node, c);
+            if (nextNode < 0) {
+                nextNode = trie.size();
+                trie.push_back(TrieNode());
+                auto& next = trie[node].next;
+                next.insert(lower_bound(next.begin(), next.end(), make_pair(c, -1)),
+                            make_pair(c, nextNode));
+            }
+            node = nextNode;
+        }
+        trie[node].station = id;
+
+        if (bkTree.empty()) {
+            bkTree.push_back({id, {}});
+            return;
+        }
+        int bk = 0;
+        while (true) {
+            int d = editDistance(key, keys[bkTree[bk].station], INT32_MAX / 2);
+            int nextBk = -1;
+            for (auto &edge : bkTree[bk].children) {
+                if (edge.first == d) { nextBk = edge.second; break; }
+            }
+            if (nextBk < 0) {
+                bkTree[bk].children.push_back({d, (int)bkTree.size()});
+                bkTree.push_back({id, {}});
+                return;
+            }
+            bk = nextBk;
+        }
+    }
+
+    void addTrain(const Train& train) {
+        add(train.source);
+        for (auto &station : train.stations) add(station);
+        add(train.destination);
+    }
+
+    void rebuild() {
+        clear();
+        for (auto &train : trains) addTrain(train);
+    }
+
+    // Canonical spelling of a case-insensitive exact match, or ""
+    string resolve(const string& input) const {
+        auto it = byKey.find(lowercase(input));
+        return it == byKey.end() ? string() : names[it->second];
+    }
+
+    // Stations starting with prefix, alphabetically
+    vector<string> complete(const string& prefix, size_t limit) const {
+        vector<string> out;
+        int node = 0;
+        for (char c : lowercase(prefix)) {
+            node = child(node, c);
+            if (node < 0) return out;
+        }
+        collect(node, limit, out);
+        return out;
+    }
+
+    // Stations within maxDistance edits, closest first
+    vector<string> suggest(const string& input, int maxDistance, size_t limit) const {
+        vector<pair<int, int>> found;   // (distance, station)
+        if (bkTree.empty()) return {};
+        string key = lowercase(input);
+        vector<int> pending = {0};
+        while (!pending.empty()) {
+            const BkNode& node = bkTree[pending.back()];
+            pending.pop_back();
+            int d = editDistance(key, keys[node.station], INT32_MAX / 2);
+            if (d <= maxDistance) found.push_back({d, node.station});
+            for (auto &edge : node.children) {
+                if (edge.first >= d - maxDistance && edge.first <= d + maxDistance) {
+                    pending.push_back(edge.second);
+                }
+            }
+        }
+        sort(found.begin(), found.end());
+        vector<string> out;
+        for (size_t i = 0; i < found.size() && out.size() < limit; i++) {
+            out.push_back(names[found[i].second]);
+        }
+        return out;
+    }
+};
+
+StationDictionary stationDictionary;
+
+vector<string> stationsOnRoute(const Train& train) {
+    vector<string> route = {train.source};
+    route.insert(route.end(), train.stations.begin(), train.stations.end());
+    route.push_back(train.destination);
+    return route;
+}
+
+const size_t STATION_SUGGESTIONS = 5;
+
+// Prefix completions first, then spelling suggestions, without repeats.
+// If allowed is given, only those stations are offered.
+vector<string> stationCandidates(const string& input, const vector<string>* allowed) {
+    int maxDistance = input.size() <= 4 ? 1 : 2;
+    vector<string> candidates = stationDictionary.complete(input, STATION_SUGGESTIONS * 4);
+    for (auto &name : stationDictionary.suggest(input, maxDistance, STATION_SUGGESTIONS * 4)) {
+        if (find(candidates.begin(), candidates.end(), name) == candidates.end()) {
+            candidates.push_back(name);
+        }
+    }
+    vector<string> result;
+    for (auto &name : candidates) {
+        if (allowed && find(allowed->begin(), allowed->end(), name) == allowed->end()) continue;
+        result.push_back(name);
+        if (result.size() >= STATION_SUGGESTIONS) break;
+    }
+    return result;
+}
+
+// Known spelling of a station name, or "" if it is not one
+string resolveStation(const string& input) {
+    return stationDictionary.resolve(input);
+}
+
+// ==================== TRAIN RUNS ====================
+
+// Days since 1970-01-01 for a DD-MM-YYYY date, or -1 if malformed
+int dayNumber(const string& date) {
+    if (date.length() != 10 || date[2] != '-' || date[5] != '-') return -1;
+    string dayStr = date.substr(0, 2);
+    string monthStr = date.substr(3, 2);
+    string yearStr = date.substr(6, 4);
+    if (!isNumber(dayStr) || !isNumber(monthStr) || !isNumber(yearStr)) return -1;
+
+    int d = stoi(dayStr), m = stoi(monthStr), y = stoi(yearStr);
+    if (m < 1 || m > 12 || d < 1 || d > 31) return -1;
+
+    // Civil-from-days inverse (proleptic Gregorian calendar)
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yearOfEra = y - era * 400;
+    int dayOfYear = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+int todayDayNumber() {
+    time_t now = time(0);
+    tm* local = localtime(&now);
+    stringstream ss;
+    ss << setfill('0') << setw(2) << local->tm_mday << "-"
+       << setw(2) << local->tm_mon + 1 << "-" << local->tm_year + 1900;
+    return dayNumber(ss.str());
+}
+
+// Position of a station along the train's route: 0 = source, then the
+// intermediate stations, then the destination. -1 if the train skips it.
+int stationIndex(const Train& train, const string& station) {
+    if (station == train.source) return 0;
+    for (size_t i = 0; i < train.stations.size(); i++) {
+        if (train.stations[i] == station) return i + 1;
+    }
+    if (station == train.destination) return train.stations.size() + 1;
+    return -1;
+}
+
+// Seats occupied on each station-to-station segment of one train run.
+// Range add / range max segment tree: maxOccupied[node] already includes
+// the pending add of the node itself, so no push-down is needed.
+class OccupancyTree {
+public:
+    OccupancyTree(int segmentCount = 0) {
+        reset(segmentCount);
+    }
+
+    void reset(int segmentCount) {
+        segments = max(1, segmentCount);
+        maxOccupied.assign(4 * segments, 0);
+        pendingAdd.assign(4 * segments, 0);
+    }
+
+    // Add delta passengers on segments [from, to)
+    void add(int from, int to, int delta) {
+        if (from < to) update(1, 0, segments, from, to, delta);
+    }
+
+    // Highest occupancy on any segment in [from, to)
+    int maxOccupancy(int from, int to) const {
+        return from < to ? query(1, 0, segments, from, to) : 0;
+    }
+
+    void accountMemory(MemoryUsage& usage) const {
+        usage.add(maxOccupied);
+        usage.add(pendingAdd);
+    }
+
+private:
+    int segments;
+    vector<int> maxOccupied;
+    vector<int> pendingAdd;
+
+    void update(int node, int lo, int hi, int from, int to, int delta) {
+        if (to <= lo || hi <= from) return;
+        if (from <= lo && hi <= to) {
+            maxOccupied[node] += delta;
+            pendingAdd[node] += delta;
+            return;
+        }
+        int mid = (lo + hi) / 2;
+        update(2 * node, lo, mid, from, to, delta);
+        update(2 * node + 1, mid, hi, from, to, delta);
+        maxOccupied[node] = max(maxOccupied[2 * node], maxOccupied[2 * node + 1]) + pendingAdd[node];
+    }
+
+    int query(int node, int lo, int hi, int from, int to) const {
+        if (to <= lo || hi <= from) return 0;
+        if (from <= lo && hi <= to) return maxOccupied[node];
+        int mid = (lo + hi) / 2;
+        return max(query(2 * node, lo, mid, from, to),
+                   query(2 * node + 1, mid, hi, from, to)) + pendingAdd[node];
+    }
+};
+
+// Waitlisted booking; earlier joiners are promoted first
+struct WaitlistEntry {
+    uint64_t sequence;
+    size_t bookingIndex;
+
+    bool operator<(const WaitlistEntry& other) const {
+        return sequence > other.sequence;   // priority_queue pops the smallest sequence
+    }
+};
+
+// Seat inventory of one train on one travel date
+class TrainRun {
+public:
+    string trainId;
+    string date;
+    int travelDay;
+    SeatMap seats;
+    OccupancyTree occupancy;
+    priority_queue<WaitlistEntry> waitlist;
+    uint64_t nextWaitlistSequence;
+    // Meals to load for confirmed passengers, per MealType
+    int preferenceMeals[MEAL_TYPE_COUNT];   // chosen at booking, one per passenger
+    int orderedMeals[MEAL_TYPE_COUNT];      // catering orders
+    vector<uint32_t> bookingSlots;          // Every booking made on the run
+
+    void reset(const Train& train, const string& runDate, int day) {
+        trainId = train.trainId;
+        date = runDate;
+        travelDay = day;
+        seats.reset(train.totalSeats, train.stations.size() + 1);
+        occupancy.reset(train.stations.size() + 1);
+        waitlist = priority_queue<WaitlistEntry>();
+        nextWaitlistSequence = 0;
+        fill(preferenceMeals, preferenceMeals + MEAL_TYPE_COUNT, 0);
+        fill(orderedMeals, orderedMeals + MEAL_TYPE_COUNT, 0);
+        bookingSlots.clear();
+    }
+
+    void joinWaitlist(size_t bookingIndex) {
+        waitlist.push({nextWaitlistSequence++, bookingIndex});
+    }
+};
+
+// Hands out TrainRun objects from fixed-size blocks. Released runs go on a
+// free list and are reused with their bitmap/tree allocations intact.
+class TrainRunPool {
+public:
+    static const size_t BLOCK_SIZE = 64;
+
+    TrainRunPool() : liveCount(0) {}
+
+    TrainRun* acquire() {
+        if (freeList.empty()) {
+            blocks.push_back(unique_ptr<TrainRun[]>(new TrainRun[BLOCK_SIZE]));
+            for (size_t i = BLOCK_SIZE; i > 0; i--) {
+                freeList.push_back(&blocks.back()[i - 1]);
+            }
+        }
+        TrainRun* run = freeList.back();
+        freeList.pop_back();
+        liveCount++;
+        return run;
+    }
+
+    void release(TrainRun* run) {
+        freeList.push_back(run);
+        liveCount--;
+    }
+
+    void clear() {
+        freeList.clear();
+        for (auto &block : blocks) {
+            for (size_t i = BLOCK_SIZE; i > 0; i--) freeList.push_back(&block[i - 1]);
+        }
+        liveCount = 0;
+    }
+
+    size_t live() const { return liveCount; }
+    size_t capacity() const { return blocks.size() * BLOCK_SIZE; }
+
+    // Released runs keep their allocations, so every pooled run is counted
+    void accountMemory(MemoryUsage& usage) const {
+        usage.add(blocks);
+        usage.add(freeList);
+        for (auto &block : blocks) {
+            usage.addBlock(BLOCK_SIZE * sizeof(TrainRun) + sizeof(size_t));
+            for (size_t i = 0; i < BLOCK_SIZE; i++) {
+                const TrainRun& run = block[i];
+                usage.add(run.trainId);
+                usage.add(run.date);
+                usage.add(run.seats.freeBits);
+                run.occupancy.accountMemory(usage);
+                usage.addBlock(run.waitlist.size() * sizeof(WaitlistEntry));
+                usage.add(run.bookingSlots);
+            }
+        }
+    }
+
+private:
+    vector<unique_ptr<TrainRun[]>> blocks;
+    vector<TrainRun*> freeList;
+    size_t liveCount;
+};
+
+TrainRunPool trainRunPool;
+unordered_map<string, TrainRun*> trainRuns;   // "trainId|date" -> run
+// One pantry stocks every train, so the preference meals of all upcoming
+// runs are set aside from the same stock: the sum of their preferenceMeals
+int reservedPreferenceMeals[MEAL_TYPE_COUNT] = {};
+int lastRunSweepDay = -1;
+
+string runKey(const string& trainId, const string& date) {
+    return trainId + "|" + date;
+}
+
+// Existing run, or nullptr if nothing has been booked on it yet
+TrainRun* findTrainRun(const string& trainId, const string& date) {
+    auto it = trainRuns.find(runKey(trainId, date));
+    return it == trainRuns.end() ? nullptr : it->second;
+}
+
+// Run for the date, created on first use; nullptr for a malformed date
+TrainRun* materializeTrainRun(const Train& train, const string& date) {
+    string key = runKey(train.trainId, date);
+    auto it = trainRuns.find(key);
+    if (it != trainRuns.end()) return it->second;
+
+    int day = dayNumber(date);
+    if (day < 0) return nullptr;
+
+    TrainRun* run = trainRunPool.acquire();
+    run->reset(train, date, day);
+    trainRuns[key] = run;
+    return run;
+}
+
+void learnTravelledRun(const TrainRun& run);
+void finishTravelledSweep(int today);
+
+// Return runs whose travel date has passed to the pool (once per day). The
+// cancellation model learns from their bookings on the way out, so only
+// the bookings that just travelled are visited.
+int releasePastTrainRuns() {
+    int today = todayDayNumber();
+    if (today == lastRunSweepDay) return 0;
+    lastRunSweepDay = today;
+
+    int released = 0;
+    for (auto it = trainRuns.begin(); it != trainRuns.end(); ) {
+        if (it->second->travelDay < today) {
+            learnTravelledRun(*it->second);
+            for (int t = 0; t < MEAL_TYPE_COUNT; t++) {
+                reservedPreferenceMeals[t] -= it->second->preferenceMeals[t];
+            }
+            trainRunPool.release(it->second);
+            it = trainRuns.erase(it);
+            released++;
+        } else {
+            ++it;
+        }
+    }
+    finishTravelledSweep(today);
+    return released;
+}
+
+void clearTrainRuns() {
+    trainRuns.clear();
+    fill(reservedPreferenceMeals, reservedPreferenceMeals + MEAL_TYPE_COUNT, 0);
+    trainRunPool.clear();
+    lastRunSweepDay = -1;
+}
+
+// Add (delta = +1) or remove (delta = -1) the booking's passengers on the
+// segments it travels
+void addSegmentOccupancy(TrainRun* run, const Train& train, const Booking& booking, int delta) {
+    int from = stationIndex(train, booking.source);
+    int to = stationIndex(train, booking.destination);
+    if (from >= 0 && to > from) {
+        run->occupancy.add(from, to, delta * (int)booking.passengers.size());
+    }
+}
+
+// Seat the booking's passengers on the segments it travels
+bool allocateSeats(TrainRun* run, const Train& train, const Booking& booking, vector<int>& seats) {
+    return run->seats.allocate(booking.passengers.size(), stationIndex(train, booking.source),
+                               stationIndex(train, booking.destination), seats);
+}
+
+// Hold (held = true) or free the booking's seats on the segments it travels
+void holdSeats(TrainRun* run, const Train& train, const Booking& booking, bool held) {
+    int from = stationIndex(train, booking.source);
+    int to = stationIndex(train, booking.destination);
+    for (int seat : booking.seatNumbers) {
+        if (held) run->seats.occupy(seat, from, to);
+        else run->seats.release(seat, from, to);
+    }
+}
+
+// Add (delta = +1) or remove (delta = -1) one meal per passenger of the
+// booked preference
+void addPreferenceMeals(TrainRun* run, const Booking& booking, int delta) {
+    int type = preferenceMealType(booking.mealPreference);
+    if (type < 0) return;
+    run->preferenceMeals[type] += delta * (int)booking.passengers.size();
+    reservedPreferenceMeals[type] += delta * (int)booking.passengers.size();
+}
+
+void addOrderedMeal(TrainRun* run, const CateringOrderLine& line, int delta) {
+    int type = mealTypeIndex(cateringMenu[line.itemSlot].type);
+    if (type >= 0) run->orderedMeals[type] += delta * line.quantity;
+}
+
+// Add or remove all of the booking's meals, including catering orders
+void addMealDemand(TrainRun* run, size_t bookingSlot, int delta) {
+    addPreferenceMeals(run, bookings[bookingSlot], delta);
+    cateringLedger.forBooking(bookingSlot, [&](const CateringOrderLine& line) {
+        addOrderedMeal(run, line, delta);
+    });
+}
+
+// Seats free for the whole journey from -> to on the given date, or -1 if
+// the train or stations are unknown. Read from the seat bitmaps the
+// allocator uses, so a booking of this many seats will be confirmed.
+// O(segments x coach words).
+int availableSeatsBetween(const string& trainId, const string& date,
+                          const string& from, const string& to) {
+    Train* train = findTrain(trainId);
+    if (!train) return -1;
+    int fromIndex = stationIndex(*train, from);
+    int toIndex = stationIndex(*train, to);
+    if (fromIndex < 0 || toIndex <= fromIndex) return -1;
+
+    TrainRun* run = findTrainRun(trainId, date);
+    return run ? run->seats.freeSeats(fromIndex, toIndex) : SeatMap::capacityFor(train->totalSeats);
+}
+
+// ==================== CANCELLATION MODEL ====================
+//
+// Logistic regression over a few fixed booking features, learned online:
+// each cancellation is a positive example and each confirmed booking whose
+// travel date has passed a negative one, one SGD step per outcome. The
+// weights are checkpointed with the data files in cancel_model.dat, and
+// cancellations journaled after the checkpoint are learned again on load.
+// Part of the engine state, so guarded by engineMutex like the tables.
+
+const int CANCEL_FEATURES = 8;
+const float CANCEL_LEARNING_RATE = 0.05f;
+const float CANCEL_L2 = 0.0001f;
+const int UNKNOWN_LEAD_DAYS = 30;       // Bookings from before bookedDay was kept
+
+struct alignas(32) CancelFeatures {
+    float x[CANCEL_FEATURES];
+};
+
+// Only features fixed when the booking is made, so it scores the same when
+// predicted, when learned from and after a reload
+CancelFeatures cancelFeatures(const Booking& booking) {
+    int travelDay = dayNumber(booking.date);
+    int lead = booking.bookedDay ? travelDay - booking.bookedDay : UNKNOWN_LEAD_DAYS;
+    float group = (float)booking.passengers.size();
+    float perPassenger = 1.0f / max(1.0f, group);
+    float children = 0.0f, seniors = 0.0f;
+    for (auto &passenger : booking.passengers) {
+        children += passenger.age <= 12;
+        seniors += passenger.age >= 60;
+    }
+    int weekday = (travelDay % 7 + 11) % 7;     // 0 = Sunday (day 0 was a Thursday)
+
+    CancelFeatures f;
+    f.x[0] = 1.0f;                                              // Bias
+    f.x[1] = min(max(lead, 0), BOOKING_HORIZON_DAYS) / 30.0f;   // Months booked ahead
+    f.x[2] = group / 6.0f;
+    f.x[3] = min((float)booking.fare * perPassenger / 5000.0f, 2.0f);
+    f.x[4] = booking.mealPreference != MEAL_PREF_NONE;
+    f.x[5] = children * perPassenger;
+    f.x[6] = seniors * perPassenger;
+    f.x[7] = weekday % 6 == 0;                                  // Saturday or Sunday
+    return f;
+}
+
+class CancellationModel {
+public:
+    alignas(32) float weights[CANCEL_FEATURES];
+    uint64_t updates;           // Outcomes learned
+    uint64_t cancellations;     // Of which cancelled
+    int trainedThroughDay;      // Travelled bookings up to this day are learned
+
+    CancellationModel() { reset(); }
+
+    // Prior close to the old fixed heuristic, used until outcomes arrive
+    void reset() {
+        const float prior[CANCEL_FEATURES] = {-1.0f, 0.5f, 1.0f, 0.5f, -0.7f, 0.0f, 0.0f, 0.0f};
+        copy(prior, prior + CANCEL_FEATURES, weights);
+        updates = 0;
+        cancellations = 0;
+        trainedThroughDay = -1;
+    }
+
+    // Branch-free: fixed-length dot product and a clamped logistic
+    float score(const CancelFeatures& f) const {
+        float z = 0.0f;
+        for (int i = 0; i < CANCEL_FEATURES; i++) z += weights[i] * f.x[i];
+        z = min(max(z, -30.0f), 30.0f);
+        return 1.0f / (1.0f + exp(-z));
+    }
+
+    // One SGD step on the log loss with a little L2 shrinkage
+    void learn(const Booking& booking, bool cancelled) {
+        CancelFeatures f = cancelFeatures(booking);
+        float step = CANCEL_LEARNING_RATE * ((float)cancelled - score(f));
+        for (int i = 0; i < CANCEL_FEATURES; i++) {
+            weights[i] += step * f.x[i] - CANCEL_LEARNING_RATE * CANCEL_L2 * weights[i];
+        }
+        updates++;
+        cancellations += cancelled;
+    }
+
+    // Learn the confirmed bookings that travelled after trainedThroughDay and
+    // before today. Scans the bookings, so only on load; while running the
+    // run sweep feeds in each released run through learnRun.
+    void learnTravelled(int today) {
+        if (today - 1 <= trainedThroughDay) return;
+        for (auto &booking : bookings) {
+            int day = dayNumber(booking.date);
+            if (day > trainedThroughDay && day < today && booking.status == BOOKING_CONFIRMED) learn(booking, false);
+        }
+        trainedThroughDay = today - 1;
+    }
+
+    void learnRun(const TrainRun& run) {
+        if (run.travelDay <= trainedThroughDay) return;
+        for (uint32_t slot : run.bookingSlots) {
+            const Booking& booking = bookings[slot];
+            if (booking.status == BOOKING_CONFIRMED) learn(booking, false);
+        }
+    }
+
+    // Without a saved model, learn every outcome already in the tables
+    void bootstrap(int today) {
+        reset();
+        for (auto &booking : bookings) {
+            if (booking.status == BOOKING_CANCELLED) learn(booking, true);
+        }
+        learnTravelled(today);
+    }
+
+    // "trainedThroughDay|updates|cancellations|w0..w7", weights as the hex
+    // bits of each float so they reload exactly
+    string serialize() const {
+        stringstream out;
+        out << trainedThroughDay << "|" << updates << "|" << cancellations << hex << setfill('0');
+        for (float w : weights) {
+            uint32_t bits;
+            memcpy(&bits, &w, sizeof(bits));
+            out << "|" << setw(8) << bits;
+        }
+        return out.str();
+    }
+
+    bool parse(const vector<string>& tokens) {
+        if (tokens.size() != 3 + CANCEL_FEATURES) return false;
+        if (!isNumber(tokens[0]) || !isNumber(tokens[1]) || !isNumber(tokens[2])) return false;
+        float loaded[CANCEL_FEATURES];
+        for (int i = 0; i < CANCEL_FEATURES; i++) {
+            const string& field = tokens[3 + i];
+            if (field.size() != 8 || field.find_first_not_of("0123456789abcdef") != string::npos) return false;
+            uint32_t bits = stoul(field, nullptr, 16);
+            memcpy(&loaded[i], &bits, sizeof(bits));
+        }
+        copy(loaded, loaded + CANCEL_FEATURES, weights);
+        trainedThroughDay = stoi(tokens[0]);
+        updates = stoull(tokens[1]);
+        cancellations = stoull(tokens[2]);
+        return true;
+    }
+};
+
+CancellationModel cancellationModel;
+
+void learnTravelledRun(const TrainRun& run) { cancellationModel.learnRun(run); }
+
+// Every run before today has been released and learned by now
+void finishTravelledSweep(int today) {
+    cancellationModel.trainedThroughDay = max(cancellationModel.trainedThroughDay, today - 1);
+}
+
+// ==================== FILE PERSISTENCE ====================
+
+string serializeTrain(const Train& train) {
+    stringstream out;
+    out << train.trainId << "|" << train.name << "|" 
+        << train.source << "|" << train.destination << "|"
+        << train.totalSeats << "|" << train.farePerKm << "|"
+        << train.departureTime << "|" << train.arrivalTime;
+
+    // Save stations and distances
+    out << "|" << train.stations.size();
+    for (size_t i = 0; i < train.stations.size(); i++) {
+        out << "|" << train.stations[i] << "|" << train.distances[i];
+    }
+    return out.str();
+}
+
+string serializeBooking(const Booking& booking) {
+    stringstream out;
+    out << formatPnr(booking.pnr) << "|" << booking.trainId << "|"
+        << booking.source << "|" << booking.destination << "|"
+        << booking.date << "|" << booking.fare << "|"
+        << mealPreferenceNames[booking.mealPreference] << "|" << booking.passengers.size();
+
+    // Save passengers
+    for (auto &passenger : booking.passengers) {
+        out << "|" << passenger.name << "|" << passenger.age 
+            << "|" << formatGender(passenger.gender) << "|" << formatContact(passenger.contact);
+    }
+
+    // Save allocated seats
+    out << "|" << booking.seatNumbers.size();
+    for (int seat : booking.seatNumbers) {
+        out << "|" << seat;
+    }
+    out << "|" << formatBookingStatus(booking.status) << "|" << booking.refund << "|" << booking.bookedDay;
+    return out.str();
+}
+
+// Split a '|' separated record into fields
+void splitFields(const char* begin, const char* end, vector<string>& tokens) {
+    tokens.clear();
+    const char* fieldStart = begin;
+    for (const char* p = begin; p < end; p++) {
+        if (*p == '|') {
+            tokens.emplace_back(fieldStart, p);
+            fieldStart = p + 1;
+        }
+    }
+    if (fieldStart < end) {
+        tokens.emplace_back(fieldStart, end);
+    }
+}
+
+bool parseTrainRecord(const vector<string>& tokens, Train& train) {
+    if (tokens.size() < 8 || !isNumber(tokens[4])) return false;
+
+    train = Train(tokens[0], tokens[1], tokens[2], tokens[3], stoi(tokens[4]));
+    if (isDouble(tokens[5])) {
+        train.farePerKm = stod(tokens[5]);
+    }
+    train.departureTime = tokens[6];
+    train.arrivalTime = tokens[7];
+
+    // Load stations and distances
+    if (tokens.size() > 8 && isNumber(tokens[8])) {
+        int stationCount = stoi(tokens[8]);
+        size_t index = 9;
+        for (int i = 0; i < stationCount && index + 1 < tokens.size(); i++) {
+            train.stations.push_back(tokens[index]);
+            if (isNumber(tokens[index + 1])) {
+                train.distances.push_back(stoi(tokens[index + 1]));
+            }
+            index += 2;
+        }
+    }
+    return true;
+}
+
+// Booking-shaped records parseBookingRecord could not read
+atomic<size_t> unreadableBookingRecords(0);
+
+bool refuseBookingRecord() {
+    unreadableBookingRecords++;
+    return false;
+}
+
+bool parseBookingRecord(const vector<string>& tokens, Booking& booking) {
+    if (tokens.size() < 8) return false;
+
+    booking = Booking(tokens[1], tokens[2], tokens[3]);
+    booking.pnr = parsePnr(tokens[0]);
+    if (!booking.pnr) return refuseBookingRecord();
+    booking.date = tokens[4];
+
+    if (isDouble(tokens[5])) {
+        booking.fare = stod(tokens[5]);
+    }
+
+    booking.mealPreference = parseMealPreference(tokens[6]);
+
+    // Load passengers
+    if (isNumber(tokens[7])) {
+        int passengerCount = stoi(tokens[7]);
+        size_t index = 8;
+        for (int i = 0; i < passengerCount && index + 3 < tokens.size(); i++) {
+            string name = tokens[index];
+            int age = 0;
+            if (isNumber(tokens[index + 1])) {
+                age = stoi(tokens[index + 1]);
+            }
+            // Text older versions accepted is kept as it was written
+            Gender gender;
+            if (!loadGender(tokens[index + 2], gender)) return refuseBookingRecord();
+            uint64_t contact = loadContact(tokens[index + 3]);
+
+            booking.passengers.push_back(Passenger(name, age, gender, contact));
+            index += 4;
+        }
+
+        // Load allocated seats (absent in older files)
+        if (index < tokens.size() && isNumber(tokens[index])) {
+            int seatCount = stoi(tokens[index++]);
+            for (int i = 0; i < seatCount && index < tokens.size(); i++, index++) {
+                if (isNumber(tokens[index])) booking.seatNumbers.push_back(stoi(tokens[index]));
+            }
+        }
+
+        // Load status and refund (absent in older files)
+        if (index < tokens.size() && !tokens[index].empty()) {
+            if (!parseBookingStatus(tokens[index++], booking.status)) return refuseBookingRecord();
+        }
+        if (index < tokens.size() && isDouble(tokens[index])) {
+            booking.refund = stod(tokens[index]);
+        }
+        index++;
+
+        // Day the booking was made (absent in older files)
+        if (index < tokens.size() && isNumber(tokens[index])) {
+            booking.bookedDay = stoi(tokens[index]);
+        }
+    }
+    return true;
+}
+
+// Older bookings.dat files kept catering orders in the meal field after the
+// booked preference, e.g. "Veg, Non-Veg (2x Egg Curry)". Move them to the ledger.
+void migrateLegacyCateringOrders(const string& bookingContents) {
+    stringstream ss(bookingContents);
+    string line;
+    vector<string> tokens;
+    while (getline(ss, line)) {
+        if (line.find(" (") == string::npos) continue;
+        splitFields(line.c_str(), line.c_str() + line.size(), tokens);
+        if (tokens.size() < 7) continue;
+        long slot = findBookingIndex(tokens[0]);
+        if (slot < 0) continue;
+
+        const string& meals = tokens[6];
+        size_t start = 0;
+        while (start < meals.size()) {
+            size_t end = meals.find(", ", start);
+            if (end == string::npos) end = meals.size();
+            string entry = meals.substr(start, end - start);
+            start = end + 2;
+
+            size_t open = entry.find(" (");
+            if (open == string::npos) continue;
+            size_t times = entry.find("x ", open);
+            if (times == string::npos || entry.back() != ')') continue;
+            string name = entry.substr(times + 2, entry.size() - times - 3);
+            int quantity = atoi(entry.c_str() + open + 2);
+            for (auto &item : cateringMenu) {
+                if (item.name == name && quantity > 0) {
+                    recordCateringOrder(slot, item, quantity);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool readWholeFile(const string& filename, string& contents) {
+    ifstream in(filename, ios::binary);
+    if (!in.is_open()) return false;
+    stringstream buffer;
+    buffer << in.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+// Parse every line in [begin, end) with the given record parser
+template <typename Record, typename Parser>
+void parseLines(const char* begin, const char* end, vector<Record>& out, Parser parse) {
+    vector<string> tokens;
+    const char* lineStart = begin;
+    while (lineStart < end) {
+        const char* lineEnd = lineStart;
+        while (lineEnd < end && *lineEnd != '\n') lineEnd++;
+
+        if (lineEnd > lineStart) {
+            splitFields(lineStart, lineEnd, tokens);
+            Record record;
+            if (parse(tokens, record)) {
+                out.push_back(move(record));
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+}
+
+// Below this many bytes per chunk a worker thread costs more than it saves
+const size_t MIN_PARSE_CHUNK_BYTES = 256 * 1024;
+
+// Split the file into newline-aligned chunks, parse them on worker threads
+// into per-chunk buffers and concatenate the buffers in file order.
+template <typename Record, typename Parser>
+vector<Record> parseFileParallel(const string& contents, Parser parse) {
+    size_t workers = thread::hardware_concurrency();
+    if (workers == 0) workers = 1;
+    size_t chunkCount = min(workers, contents.size() / MIN_PARSE_CHUNK_BYTES + 1);
+
+    const char* data = contents.data();
+    const char* dataEnd = data + contents.size();
+
+    vector<const char*> bounds;
+    bounds.push_back(data);
+    for (size_t i = 1; i < chunkCount; i++) {
+        const char* cut = data + contents.size() * i / chunkCount;
+        if (cut < bounds.back()) cut = bounds.back();
+        while (cut < dataEnd && *cut != '\n') cut++;
+        if (cut < dataEnd) cut++;
+        bounds.push_back(cut);
+    }
+    bounds.push_back(dataEnd);
+
+    vector<vector<Record>> parts(chunkCount);
+    vector<thread> threads;
+    for (size_t i = 1; i < chunkCount; i++) {
+        threads.push_back(thread([&, i]() {
+            parseLines(bounds[i], bounds[i + 1], parts[i], parse);
+        }));
+    }
+    parseLines(bounds[0], bounds[1], parts[0], parse);
+    for (auto &t : threads) t.join();
+
+    size_t total = 0;
+    for (auto &part : parts) total += part.size();
+
+    vector<Record> records;
+    records.reserve(total);
+    for (auto &part : parts) {
+        for (auto &record : part) {
+            records.push_back(move(record));
+        }
+    }
+    return records;
+}
+
+// ==================== REPORT SNAPSHOTS ====================
+
+// Immutable point-in-time view of the train and booking tables for reports
+struct ReportSnapshot {
+    uint64_t trainsVersion;
+    uint64_t bookingsVersion;
+    shared_ptr<const vector<Train>> trains;
+    CowTable<Booking>::Snapshot bookings;
+};
+
+// Read-copy-update publication of ReportSnapshots. The engine thread
+// publishes a new view between operations; readers on any thread pick up the
+// latest one with an atomic load and never take the engine lock. A view is
+// freed when its last reader drops it, and booking chunks it still shares
+// are copied on the engine's next write to them.
+class ReportSnapshots {
+public:
+    ReportSnapshots() : trainsVersion(0), refreshRequested(false) {}
+
+    // Any thread
+    shared_ptr<const ReportSnapshot> acquire() const { return atomic_load(&current); }
+
+    // Any thread: ask the engine for a fresh view at its next quiescent point
+    void requestRefresh() { refreshRequested.store(true, memory_order_release); }
+    bool refreshPending() const { return refreshRequested.load(memory_order_acquire); }
+
+    // Engine thread: the train list changed (trains are only ever appended
+    // or reloaded, so this is rare)
+    void trainsChanged() { trainsVersion++; }
+
+    // Engine thread: publish if a reader asked for it
+    void publishIfRequested() {
+        if (refreshRequested.exchange(false, memory_order_acq_rel)) refresh();
+    }
+
+    // Engine thread: publish a view of the current tables unless the last
+    // one is still current. Costs one pointer per booking chunk.
+    void refresh() {
+        shared_ptr<const ReportSnapshot> last = atomic_load(&current);
+        if (last && last->trainsVersion == trainsVersion && last->bookingsVersion == bookings.version()) {
+            return;
+        }
+        auto next = make_shared<ReportSnapshot>();
+        next->trainsVersion = trainsVersion;
+        next->bookingsVersion = bookings.version();
+        next->trains = (last && last->trainsVersion == trainsVersion)
+                           ? last->trains : make_shared<const vector<Train>>(trains);
+        next->bookings = bookings.snapshot();
+        atomic_store(&current, shared_ptr<const ReportSnapshot>(move(next)));
+    }
+
+    // Engine thread: refresh and return the view (reports run on the console thread)
+    shared_ptr<const ReportSnapshot> latest() {
+        refresh();
+        return acquire();
+    }
+
+private:
+    uint64_t trainsVersion;
+    atomic<bool> refreshRequested;
+    shared_ptr<const ReportSnapshot> current;
+};
+
+ReportSnapshots reportSnapshots;
+
+// ==================== JOURNAL & CHECKPOINTING ====================
+//
+// Every mutation is appended to journal.log as "<seq>|<type>|<payload>":
+//   T|<train record>   B|<booking record>
+//   C|<pnr>|<itemId>|<qty>   (catering order)
+//   I|<itemId>|<qty>         (pantry stock set)
+// A background checkpointer periodically rotates the journal to
+// journal.prev.log, writes trains.dat / bookings.dat / pantry.dat /
+// catering.dat / cancel_model.dat from a copy-on-write snapshot and then
+// deletes the rotated journal. Each data
+// file starts with "#checkpoint|<seq>", the last journal record it contains,
+// so a crash part-way through a checkpoint never replays a record twice.
+
+const char* JOURNAL_FILE = "journal.log";
+const char* JOURNAL_PREV_FILE = "journal.prev.log";
+const char* CHECKPOINT_HEADER = "#checkpoint|";
+const char* UNREADABLE_BOOKINGS_FILE = "bookings.unread.dat";   // Copy kept when records are skipped
+const size_t CHECKPOINT_INTERVAL_RECORDS = 500;
+
+class Journal {
+public:
+    Journal() {
+        nextSeq = 1;
+        sinceRotation = 0;
+        fenced = false;
+    }
+
+    bool open(uint64_t nextSequence) {
+        lock_guard<mutex> lock(journalMutex);
+        if (fenced) return false;
+        nextSeq = nextSequence;
+        out.open(JOURNAL_FILE, ios::app);
+        return out.is_open();
+    }
+
+    bool isOpen() const { return out.is_open(); }
+
+    // Stop taking records for good because a standby is taking over. Only
+    // allowed when the standby has applied everything (expectedSeq); lastSeq
+    // is set to the last record written either way.
+    bool fence(uint64_t expectedSeq, uint64_t& lastSeq) {
+        lock_guard<mutex> lock(journalMutex);
+        lastSeq = nextSeq - 1;
+        if (lastSeq != expectedSeq) return false;
+        fenced = true;
+        out.close();
+        return true;
+    }
+
+    bool isFenced() const { return fenced; }
+
+    void append(const string& type, const string& payload) {
+        lock_guard<mutex> lock(journalMutex);
+        if (!out.is_open()) return;
+        write(type, payload);
+        out.flush();
+        sinceRotation++;
+    }
+
+    // Group commit: one lock and one flush for the whole batch
+    void appendBatch(const vector<pair<string, string>>& records) {
+        lock_guard<mutex> lock(journalMutex);
+        if (!out.is_open() || records.empty()) return;
+        for (auto &record : records) write(record.first, record.second);
+        out.flush();
+        sinceRotation += records.size();
+    }
+
+    // Called with every record line as it is written, in sequence order and
+    // under the journal lock (journal shipping to a standby)
+    void setTap(function<void(uint64_t seq, const string& line)> callback) {
+        lock_guard<mutex> lock(journalMutex);
+        tap = move(callback);
+    }
+
+    // Run fn(lastSequence) with appends and rotation held off
+    template <typename Fn>
+    void paused(Fn fn) {
+        lock_guard<mutex> lock(journalMutex);
+        fn(nextSeq - 1);
+    }
+
+    uint64_t lastSequence() {
+        lock_guard<mutex> lock(journalMutex);
+        return nextSeq - 1;
+    }
+
+    size_t recordsSinceRotation() {
+        lock_guard<mutex> lock(journalMutex);
+        return sinceRotation;
+    }
+
+    // Start a fresh journal file and return the last sequence written, in
+    // one step so a checkpoint's sequence matches the file it rotated. The
+    // old file is kept until a checkpoint covering it has been written; while
+    // an earlier one is still waiting (its checkpoint failed) nothing is
+    // rotated, and the next checkpoint covers both files.
+    uint64_t rotate() {
+        lock_guard<mutex> lock(journalMutex);
+        sinceRotation = 0;
+        if (!out.is_open() || ifstream(JOURNAL_PREV_FILE).is_open()) return nextSeq - 1;
+        out.close();
+        rename(JOURNAL_FILE, JOURNAL_PREV_FILE);
+        out.open(JOURNAL_FILE, ios::app);
+        return nextSeq - 1;
+    }
+
+private:
+    mutex journalMutex;
+    ofstream out;
+    uint64_t nextSeq;
+    size_t sinceRotation;
+    atomic<bool> fenced;
+    function<void(uint64_t, const string&)> tap;
+
+    void write(const string& type, const string& payload) {
+        uint64_t seq = nextSeq++;
+        string line = to_string(seq) + "|" + type + "|" + payload;
+        out << line << "\n";
+        if (tap) tap(seq, line);
+    }
+};
+
+Journal journal;
+
+// Reported by every change once the journal is fenced
+const char* FENCED_ERROR = "This node has handed over to its standby and no longer accepts changes";
+
+// Held while a checkpoint replaces the data files and drops the rotated
+// journal, so a reader copying them sees one consistent set
+mutex checkpointFilesMutex;
+
+struct StateSnapshot {
+    uint64_t seq;   // Last journal record reflected in the snapshot
+    vector<Train> trains;
+    CowTable<Booking>::Snapshot bookings;
+    map<string, int> pantry;
+    CateringLedger::Snapshot catering;
+    vector<string> menuItemIds;     // itemSlot -> itemId
+    CancellationModel cancelModel;
+};
+
+// Called on the thread that owns the engine state. Costs a copy of the
+// (small) train list and pantry plus one pointer per booking chunk.
+// Every change already applied must be in the journal by now, or the
+// snapshot's seq would leave out a change its state holds and replay
+// would apply it (and train the cancellation model on it) twice.
+StateSnapshot captureState() {
+    StateSnapshot snap;
+    snap.seq = journal.rotate();
+    snap.trains = trains;
+    snap.bookings = bookings.snapshot();
+    snap.pantry = pantryInventory;
+    snap.catering = cateringLedger.snapshot();
+    for (auto &item : cateringMenu) snap.menuItemIds.push_back(item.itemId);
+    snap.cancelModel = cancellationModel;
+    return snap;
+}
+
+// Write through a temporary file so a crash never leaves a torn data file
+template <typename Writer>
+bool writeDataFile(const string& filename, uint64_t seq, Writer writeRecords) {
+    string tmp = filename + ".tmp";
+    {
+        ofstream out(tmp);
+        if (!out.is_open()) return false;
+        out << CHECKPOINT_HEADER << seq << "\n";
+        writeRecords(out);
+        if (!out.good()) return false;
+    }
+    return rename(tmp.c_str(), filename.c_str()) == 0;
+}
+
+void writeSnapshot(const StateSnapshot& snap) {
+    ScopedLatency latency(OP_SAVE);
+    TraceSpan span("saveToFile");
+    lock_guard<mutex> filesLock(checkpointFilesMutex);
+
+    bool ok = writeDataFile("trains.dat", snap.seq, [&](ofstream& out) {
+        for (auto &train : snap.trains) out << serializeTrain(train) << "\n";
+    });
+    ok = writeDataFile("bookings.dat", snap.seq, [&](ofstream& out) {
+        for (auto &booking : snap.bookings) out << serializeBooking(booking) << "\n";
+    }) && ok;
+    ok = writeDataFile("pantry.dat", snap.seq, [&](ofstream& out) {
+        for (auto &entry : snap.pantry) out << entry.first << "|" << entry.second << "\n";
+    }) && ok;
+    ok = writeDataFile("catering.dat", snap.seq, [&](ofstream& out) {
+        for (size_t i = 0; i < snap.catering.size(); i++) {
+            const CateringOrderLine& line = snap.catering[i];
+            out << formatPnr(snap.bookings[line.bookingSlot].pnr) << "|" << snap.menuItemIds[line.itemSlot]
+                << "|" << line.quantity << "|" << line.price << "\n";
+        }
+    }) && ok;
+    ok = writeDataFile("cancel_model.dat", snap.seq, [&](ofstream& out) {
+        out << snap.cancelModel.serialize() << "\n";
+    }) && ok;
+
+    // The rotated journal is now fully covered by the data files
+    if (ok) remove(JOURNAL_PREV_FILE);
+}
+
+// Writes snapshots on a background thread so bookings never wait on disk
+class Checkpointer {
+public:
+    Checkpointer() {
+        running = false;
+        busy = false;
+        hasPending = false;
+    }
+
+    ~Checkpointer() { stop(); }
+
+    void start() {
+        if (running) return;
+        running = true;
+        worker = thread([this]() { run(); });
+    }
+
+    void stop() {
+        {
+            lock_guard<mutex> lock(stateMutex);
+            if (!running) return;
+            running = false;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    bool isBusy() {
+        lock_guard<mutex> lock(stateMutex);
+        return busy || hasPending;
+    }
+
+    void submit(StateSnapshot&& snap) {
+        {
+            lock_guard<mutex> lock(stateMutex);
+            pending = move(snap);
+            hasPending = true;
+        }
+        wake.notify_all();
+    }
+
+    void waitIdle() {
+        unique_lock<mutex> lock(stateMutex);
+        idle.wait(lock, [this]() { return !busy && !hasPending; });
+    }
+
+private:
+    thread worker;
+    mutex stateMutex;
+    condition_variable wake;
+    condition_variable idle;
+    bool running;
+    bool busy;
+    bool hasPending;
+    StateSnapshot pending;
+
+    void run() {
+        unique_lock<mutex> lock(stateMutex);
+        while (true) {
+            wake.wait(lock, [this]() { return hasPending || !running; });
+            if (!hasPending) break;
+
+            StateSnapshot snap = move(pending);
+            hasPending = false;
+            busy = true;
+            lock.unlock();
+            writeSnapshot(snap);
+            snap = StateSnapshot();   // Drop chunk references before going idle
+            lock.lock();
+            busy = false;
+            idle.notify_all();
+        }
+    }
+};
+
+Checkpointer checkpointer;
+
+void maybeCheckpoint() {
+    if (journal.recordsSinceRotation() >= CHECKPOINT_INTERVAL_RECORDS && !checkpointer.isBusy()) {
+        checkpointer.submit(captureState());
+    }
+}
 
-    return ss.str();
+// Journal a mutation and hand a snapshot to the checkpointer when due
+void logMutation(const string& type, const string& payload) {
+    if (!journal.isOpen()) return;
+    journal.append(type, payload);
+    maybeCheckpoint();
 }
 
-// Function to calculate distance between two stations on a route
-int calculateRouteDistance(Train* train, const string& source, const string& destination) {
-    // Find positions of source and destination
-    int sourcePos = -1, destPos = -1;
+void logMutations(const vector<pair<string, string>>& records) {
+    if (!journal.isOpen()) return;
+    journal.appendBatch(records);
+    maybeCheckpoint();
+}
 
-    // Check if source is the starting station
-    if (source == train->source) {
-        sourcePos = 0;
-    }
+// Synchronous full checkpoint (used on exit)
+void saveToFile() {
+    checkpointer.waitIdle();
+    writeSnapshot(captureState());
+}
 
-    // Check if destination is the ending station
-    if (destination == train->destination) {
-        destPos = train->stations.size() + 1;
-    }
+uint64_t checkpointSequence(const string& contents) {
+    size_t headerLength = strlen(CHECKPOINT_HEADER);
+    if (contents.compare(0, headerLength, CHECKPOINT_HEADER) != 0) return 0;
+    size_t lineEnd = contents.find('\n');
+    string seq = contents.substr(headerLength, lineEnd == string::npos ? string::npos : lineEnd - headerLength);
+    return isNumber(seq) ? stoull(seq) : 0;
+}
 
-    // Check intermediate stations
-    for (int i = 0; i < train->stations.size(); i++) {
-        if (train->stations[i] == source) {
-            sourcePos = i + 1;
+// Split "<seq>|<type>|<payload>" into its parts and payload fields
+bool parseJournalLine(const string& line, uint64_t& seq, char& type, vector<string>& tokens) {
+    size_t first = line.find('|');
+    if (first == string::npos || first + 2 >= line.size() || line[first + 2] != '|') return false;
+
+    string seqStr = line.substr(0, first);
+    if (!isNumber(seqStr)) return false;
+    seq = stoull(seqStr);
+    type = line[first + 1];
+    const char* payload = line.c_str() + first + 3;
+    splitFields(payload, line.c_str() + line.size(), tokens);
+    return true;
+}
+
+// Apply one journal record to the tables whose data file predates it.
+// Train runs are not touched; callers rebuild them afterwards.
+void applyJournalRecord(uint64_t seq, char type, const vector<string>& tokens, uint64_t trainSeq,
+                        uint64_t bookingSeq, uint64_t pantrySeq, uint64_t cateringSeq, uint64_t modelSeq) {
+    if (type == 'T' && seq > trainSeq) {
+        Train train;
+        if (parseTrainRecord(tokens, train)) trains.push_back(train);
+    } else if (type == 'B' && seq > bookingSeq) {
+        Booking booking;
+        if (parseBookingRecord(tokens, booking)) appendBooking(booking);
+    } else if (type == 'C' && tokens.size() >= 3 && isNumber(tokens[2])) {
+        CateringItem* item = findCateringItem(tokens[1]);
+        if (!item) return;
+        int quantity = stoi(tokens[2]);
+        if (seq > pantrySeq) {
+            setPantryStock(item->itemId, pantryInventory[item->itemId] - quantity);
         }
-        if (train->stations[i] == destination) {
-            destPos = i + 1;
+        if (seq > cateringSeq) {
+            long index = findBookingIndex(tokens[0]);
+            if (index >= 0) recordCateringOrder(index, *item, quantity);
         }
+    } else if (type == 'I' && seq > pantrySeq && tokens.size() >= 2 && isNumber(tokens[1])) {
+        setPantryStock(tokens[0], stoi(tokens[1]));
+    } else if (type == 'X' && (seq > bookingSeq || seq > modelSeq || seq > pantrySeq || seq > cateringSeq) &&
+               tokens.size() >= 2) {
+        // Cancellation: pnr|refund
+        long index = findBookingIndex(tokens[0]);
+        if (index < 0) return;
+        if (seq > modelSeq) cancellationModel.learn(bookings[index], true);
+        reverseCateringOrders(index, seq > cateringSeq, seq > pantrySeq);
+        if (seq <= bookingSeq) return;
+        Booking& booking = bookings.mutate(index);
+        booking.status = BOOKING_CANCELLED;
+        booking.refund = isDouble(tokens[1]) ? stod(tokens[1]) : 0.0;
+        booking.seatNumbers.clear();
+    } else if (type == 'P' && seq > bookingSeq && tokens.size() >= 2 && isNumber(tokens[1])) {
+        // Waitlist promotion: pnr|seatCount|seats...
+        long index = findBookingIndex(tokens[0]);
+        if (index < 0) return;
+        Booking& booking = bookings.mutate(index);
+        booking.status = BOOKING_CONFIRMED;
+        booking.seatNumbers.clear();
+        for (size_t i = 2; i < tokens.size() && i < 2 + (size_t)stoi(tokens[1]); i++) {
+            if (isNumber(tokens[i])) booking.seatNumbers.push_back(stoi(tokens[i]));
+        }
+    }
+}
+
+// Re-apply journal records newer than the data files; returns the last sequence seen
+uint64_t replayJournalFile(const char* filename, uint64_t trainSeq, uint64_t bookingSeq,
+                           uint64_t pantrySeq, uint64_t cateringSeq, uint64_t modelSeq, uint64_t lastSeq) {
+    string contents;
+    if (!readWholeFile(filename, contents)) return lastSeq;
+
+    vector<string> lines;
+    stringstream ss(contents);
+    string line;
+    vector<string> tokens;
+    uint64_t seq;
+    char type;
+    while (getline(ss, line)) {
+        if (!parseJournalLine(line, seq, type, tokens)) continue;
+        lastSeq = max(lastSeq, seq);
+        applyJournalRecord(seq, type, tokens, trainSeq, bookingSeq, pantrySeq, cateringSeq, modelSeq);
     }
+    return lastSeq;
+}
 
-    // If both stations found and in correct order
-    if (sourcePos >= 0 && destPos >= 0 && destPos > sourcePos) {
-        if (destPos == (int)train->stations.size() + 1) {
-            // Destination is the final station
-            if (sourcePos == 0) {
-                // Source is starting station
-                return train->distances.back();
+// Re-occupy the seats held by upcoming bookings and rebuild waitlists in
+// booking order; past runs stay unmaterialized
+void rebuildTrainRuns() {
+    clearTrainRuns();
+    int today = todayDayNumber();
+    size_t unseated = 0;
+    for (size_t i = 0; i < bookings.size(); i++) {
+        const Booking& booking = bookings[i];
+        if (booking.status == BOOKING_CANCELLED) continue;
+        Train* train = findTrain(booking.trainId);
+        if (!train || dayNumber(booking.date) < today) continue;
+        TrainRun* run = materializeTrainRun(*train, booking.date);
+        if (!run) continue;
+        run->bookingSlots.push_back((uint32_t)i);
+        if (booking.status == BOOKING_WAITLISTED) {
+            run->joinWaitlist(i);
+            continue;
+        }
+        if (booking.seatNumbers.empty()) {
+            // Confirmed before seats were allocated (older files): seat it
+            // now, in booking order, so its seats are never sold again
+            vector<int> seats;
+            if (allocateSeats(run, *train, booking, seats)) {
+                Booking& seated = bookings.mutate(i);
+                seated.seatNumbers = seats;
+                seated.coach = seats[0] / max(1, run->seats.seatsPerCoach) + 1;
             } else {
-                return train->distances[destPos - 2] - train->distances[sourcePos - 2];
+                unseated++;
             }
         } else {
-            // Both are intermediate or source is starting
-            if (sourcePos == 0) {
-                return train->distances[destPos - 2];
-            } else {
-                return train->distances[destPos - 2] - train->distances[sourcePos - 2];
-            }
+            holdSeats(run, *train, booking, true);
         }
+        // booking may be stale after mutate()
+        addSegmentOccupancy(run, *train, bookings[i], +1);
+        addPreferenceMeals(run, bookings[i], +1);
+    }
+    if (unseated > 0) {
+        cout << "Warning: " << unseated << " confirmed booking(s) from older files could not be given seats; "
+             << "their runs are overbooked.\n";
     }
+    for (size_t i = 0; i < cateringLedger.size(); i++) {
+        const CateringOrderLine& line = cateringLedger[i];
+        const Booking& booking = bookings[line.bookingSlot];
+        if (booking.status != BOOKING_CONFIRMED) continue;
+        TrainRun* run = findTrainRun(booking.trainId, booking.date);
+        if (run) addOrderedMeal(run, line, +1);
+    }
+    lastRunSweepDay = today;
+}
 
-    // Default reasonable distance for common routes
-    if (source == "Mumbai" && destination == "Delhi") return 1400;
-    if (source == "Delhi" && destination == "Kolkata") return 1500;
-    if (source == "Chennai" && destination == "Bangalore") return 350;
-    if (source == "Bangalore" && destination == "Hyderabad") return 570;
-    if (source == "Delhi" && destination == "Jaipur") return 300;
-    if (source == "Mumbai" && destination == "Ahmedabad") return 530;
+// Load the last checkpoint, then replay the journal on top of it.
+// Returns the last journal sequence number applied.
+uint64_t loadFromFile() {
+    ScopedLatency latency(OP_LOAD);
+    TraceSpan span("loadFromFile");
 
-    return 500; // Default distance
-}
+    // Clear existing data
+    trains.clear();
+    bookings.clear();
+    pnrIndex.clear();
+    contactIndex.clear();
+    nameIndex.clear();
+    cateringLedger.clear();
+    routeCache.clear();
+    clearTrainRuns();
+
+    // Trains and bookings are independent, so load the train file on its own
+    // thread while the bookings are parsed
+    vector<Train> loadedTrains;
+    uint64_t trainSeq = 0;
+    thread trainLoader([&loadedTrains, &trainSeq]() {
+        string contents;
+        if (readWholeFile("trains.dat", contents)) {
+            trainSeq = checkpointSequence(contents);
+            loadedTrains = parseFileParallel<Train>(contents, parseTrainRecord);
+        }
+    });
+
+    uint64_t bookingSeq = 0;
+    string contents;
+    if (readWholeFile("bookings.dat", contents)) {
+        bookingSeq = checkpointSequence(contents);
+        unreadableBookingRecords = 0;
+        bookings.assign(parseFileParallel<Booking>(contents, parseBookingRecord));
+        // The next checkpoint rewrites bookings.dat without them, so keep
+        // the file as it was for the operator
+        if (unreadableBookingRecords > 0) {
+            ofstream copy(UNREADABLE_BOOKINGS_FILE);
+            copy << contents;
+            cout << "Warning: Skipped " << unreadableBookingRecords << " unreadable booking record(s) in bookings.dat; "
+                 << "the file as loaded is kept in " << UNREADABLE_BOOKINGS_FILE << ".\n";
+        }
+        rebuildBookingIndexes();
+        migrateLegacyCateringOrders(contents);
+    }
 
-void saveToFile() {
-    // Save trains
-    ofstream trainFile("trains.dat");
-    if (trainFile.is_open()) {
-        for (auto &train : trains) {
-            trainFile << train.trainId << "|" << train.name << "|" 
-                      << train.source << "|" << train.destination << "|"
-                      << train.totalSeats << "|" << train.farePerKm << "|"
-                      << train.departureTime << "|" << train.arrivalTime;
-
-            // Save stations and distances
-            trainFile << "|" << train.stations.size();
-            for (size_t i = 0; i < train.stations.size(); i++) {
-                trainFile << "|" << train.stations[i] << "|" << train.distances[i];
+    uint64_t pantrySeq = 0;
+    if (readWholeFile("pantry.dat", contents)) {
+        pantrySeq = checkpointSequence(contents);
+        stringstream ss(contents);
+        string line;
+        vector<string> tokens;
+        while (getline(ss, line)) {
+            splitFields(line.c_str(), line.c_str() + line.size(), tokens);
+            if (tokens.size() == 2 && isNumber(tokens[1])) {
+                setPantryStock(tokens[0], stoi(tokens[1]));
             }
-            trainFile << "\n";
         }
-        trainFile.close();
     }
 
-    // Save bookings
-    ofstream bookingFile("bookings.dat");
-    if (bookingFile.is_open()) {
-        for (auto &booking : bookings) {
-            bookingFile << booking.pnr << "|" << booking.trainId << "|"
-                       << booking.source << "|" << booking.destination << "|"
-                       << booking.date << "|" << booking.fare << "|"
-                       << booking.mealPreference << "|" << booking.passengers.size();
-
-            // Save passengers
-            for (auto &passenger : booking.passengers) {
-                bookingFile << "|" << passenger.name << "|" << passenger.age 
-                           << "|" << passenger.gender << "|" << passenger.contact;
-            }
-            bookingFile << "\n";
+    // Without a catering file the orders are still inside bookings.dat
+    uint64_t cateringSeq = bookingSeq;
+    if (readWholeFile("catering.dat", contents)) {
+        cateringSeq = checkpointSequence(contents);
+        stringstream ss(contents);
+        string line;
+        vector<string> tokens;
+        while (getline(ss, line)) {
+            splitFields(line.c_str(), line.c_str() + line.size(), tokens);
+            if (tokens.size() < 4 || !isDouble(tokens[3])) continue;
+            // Cancelled orders are reversed by a line with a negative quantity
+            const string& quantity = tokens[2];
+            if (!isNumber(quantity[0] == '-' ? quantity.substr(1) : quantity)) continue;
+            long index = findBookingIndex(tokens[0]);
+            CateringItem* item = findCateringItem(tokens[1]);
+            if (index < 0 || !item) continue;
+            cateringLedger.append({(uint32_t)index, (uint32_t)(item - cateringMenu.data()),
+                                   stoi(tokens[2]), stod(tokens[3])});
         }
-        bookingFile.close();
     }
+
+    // Without a saved model nothing is replayed into it; it is bootstrapped below
+    uint64_t modelSeq = UINT64_MAX;
+    cancellationModel.reset();
+    if (readWholeFile("cancel_model.dat", contents)) {
+        size_t lineStart = contents.find('\n') + 1;
+        size_t lineEnd = contents.find('\n', lineStart);
+        vector<string> tokens;
+        splitFields(contents.c_str() + lineStart, contents.c_str() + min(lineEnd, contents.size()), tokens);
+        if (lineStart > 0 && cancellationModel.parse(tokens)) modelSeq = checkpointSequence(contents);
+    }
+
+    trainLoader.join();
+    trains = move(loadedTrains);
+
+    uint64_t lastSeq = max(max(trainSeq, bookingSeq), max(pantrySeq, cateringSeq));
+    if (modelSeq != UINT64_MAX) lastSeq = max(lastSeq, modelSeq);
+    lastSeq = replayJournalFile(JOURNAL_PREV_FILE, trainSeq, bookingSeq, pantrySeq, cateringSeq, modelSeq, lastSeq);
+    lastSeq = replayJournalFile(JOURNAL_FILE, trainSeq, bookingSeq, pantrySeq, cateringSeq, modelSeq, lastSeq);
+
+    if (modelSeq == UINT64_MAX) {
+        cancellationModel.bootstrap(todayDayNumber());
+    } else {
+        cancellationModel.learnTravelled(todayDayNumber());
+    }
+    rebuildTrainRuns();
+    stationDictionary.rebuild();
+    stationNetwork.rebuild(trains);
+    reportSnapshots.trainsChanged();
+    return lastSeq;
 }
 
-void loadFromFile() {
-    // Clear existing data
-    trains.clear();
-    bookings.clear();
+// ==================== BOOKING CORE ====================
 
-    // Load trains
-    ifstream trainFile("trains.dat");
-    string line;
-    if (trainFile.is_open()) {
-        while (getline(trainFile, line)) {
-            if (line.empty()) continue;
+// Demand pricing: the per-km fare is scaled by how full the run already is
+// on the busiest segment of the journey, read from the run's occupancy
+// tree in O(log stations). Tiers are checked from the top.
+const FareTier FARE_TIERS[] = {
+    {0.90, 1.50, "Peak"},
+    {0.75, 1.25, "High demand"},
+    {0.50, 1.10, "Filling fast"},
+    {0.00, 1.00, "Standard"},
+};
 
-            vector<string> tokens;
-            stringstream ss(line);
-            string token;
+const FareTier& fareTierFor(const Train& train, const string& date, const string& from, const string& to) {
+    const FareTier& standard = FARE_TIERS[sizeof(FARE_TIERS) / sizeof(FARE_TIERS[0]) - 1];
+    const TrainRun* run = findTrainRun(train.trainId, date);
+    int fromIndex = stationIndex(train, from);
+    int toIndex = stationIndex(train, to);
+    int capacity = SeatMap::capacityFor(train.totalSeats);
+    if (!run || fromIndex < 0 || toIndex <= fromIndex || capacity <= 0) return standard;
+
+    double occupancy = (double)run->occupancy.maxOccupancy(fromIndex, toIndex) / capacity;
+    for (const FareTier& tier : FARE_TIERS) {
+        if (occupancy >= tier.minOccupancy) return tier;
+    }
+    return standard;
+}
 
-            while (getline(ss, token, '|')) {
-                tokens.push_back(token);
-            }
+// Fill in booking.fare from the route distance, demand tier of the run
+// and passenger age discounts
+FareBreakdown priceBooking(Booking& booking, Train* train) {
+    FareBreakdown quote = {0, 0.0, 0, 0, nullptr};
+    {
+        TraceSpan span("passengerBookTicket.distance");
+        quote.distance = calculateRouteDistance(train, booking.source, booking.destination);
+    }
 
-            if (tokens.size() >= 8) {
-                if (isNumber(tokens[4])) {
-                    Train train(tokens[0], tokens[1], tokens[2], tokens[3], stoi(tokens[4]));
-                    if (isDouble(tokens[5])) {
-                        train.farePerKm = stod(tokens[5]);
-                    }
-                    train.departureTime = tokens[6];
-                    train.arrivalTime = tokens[7];
-
-                    // Load stations and distances
-                    if (tokens.size() > 8 && isNumber(tokens[8])) {
-                        int stationCount = stoi(tokens[8]);
-                        int index = 9;
-                        for (int i = 0; i < stationCount && index + 1 < tokens.size(); i++) {
-                            train.stations.push_back(tokens[index]);
-                            if (isNumber(tokens[index + 1])) {
-                                train.distances.push_back(stoi(tokens[index + 1]));
-                            }
-                            index += 2;
-                        }
-                    }
+    TraceSpan span("passengerBookTicket.fare");
+    quote.tier = &fareTierFor(*train, booking.date, booking.source, booking.destination);
+    double perPassenger = quote.distance * train->farePerKm * quote.tier->multiplier;
+    booking.fare = perPassenger * booking.passengers.size();
 
-                    trains.push_back(train);
-                }
-            }
+    // Apply discounts for children and senior citizens
+    for (auto &passenger : booking.passengers) {
+        if (passenger.age < 5) {
+            quote.discount += perPassenger * 1.0; // Free for <5
+            quote.children++;
+        } else if (passenger.age <= 12) {
+            quote.discount += perPassenger * 0.5; // 50% off for 5-12
+            quote.children++;
+        } else if (passenger.age >= 60) {
+            quote.discount += perPassenger * 0.4; // 40% off for seniors
+            quote.seniors++;
         }
-        trainFile.close();
     }
 
-    // Load bookings
-    ifstream bookingFile("bookings.dat");
-    if (bookingFile.is_open()) {
-        while (getline(bookingFile, line)) {
-            if (line.empty()) continue;
+    booking.fare -= quote.discount;
 
-            vector<string> tokens;
-            stringstream ss(line);
-            string token;
+    // Ensure fare is not negative
+    if (booking.fare < 0) booking.fare = 0;
+    return quote;
+}
 
-            while (getline(ss, token, '|')) {
-                tokens.push_back(token);
-            }
+// Route options for a travel date, each priced with its run's demand tier.
+// The route cache keeps base fares; tiers are applied per quote.
+vector<RouteOption> quoteRoutes(const string& source, const string& dest, const string& date) {
+    vector<RouteOption> options = findRouteAlternatives(source, dest);
+    if (date.empty()) return options;
+    for (auto &option : options) {
+        option.fare *= fareTierFor(trains[option.trainIndex], date, source, dest).multiplier;
+    }
+    stable_sort(options.begin(), options.end(),
+                [](const RouteOption& a, const RouteOption& b) { return a.fare < b.fare; });
+    return options;
+}
 
-            if (tokens.size() >= 8) {
-                Booking booking(tokens[1], tokens[2], tokens[3]);
-                booking.pnr = tokens[0];
-                booking.date = tokens[4];
+// Pantry stock for the meal preference not already set aside for
+// passengers on any upcoming run (see reservedPreferenceMeals). O(1).
+int availableMeals(MealPreference preference) {
+    TraceSpan span("passengerBookTicket.pantry_check");
+    int type = preferenceMealType(preference);
+    if (type < 0) return 0;
+    return pantryByType[type] - reservedPreferenceMeals[type];
+}
 
-                if (isDouble(tokens[5])) {
-                    booking.fare = stod(tokens[5]);
-                }
+// PNR that no existing booking uses. PNRs encode the second they were issued,
+// so bookings made in the same second move on to the next free second.
+const Pnr PNR_DATE_PART = 100000000;    // low 8 digits are DDMMYYYY
 
-                booking.mealPreference = tokens[6];
-
-                // Load passengers
-                if (isNumber(tokens[7])) {
-                    int passengerCount = stoi(tokens[7]);
-                    int index = 8;
-                    for (int i = 0; i < passengerCount && index + 3 < tokens.size(); i++) {
-                        string name = tokens[index];
-                        int age = 0;
-                        if (isNumber(tokens[index + 1])) {
-                            age = stoi(tokens[index + 1]);
-                        }
-                        string gender = tokens[index + 2];
-                        string contact = tokens[index + 3];
+int pnrSecondOfDay(Pnr pnr) {
+    int hhmmss = pnr / PNR_DATE_PART;
+    return hhmmss / 10000 * 3600 + hhmmss / 100 % 100 * 60 + hhmmss % 100;
+}
 
-                        booking.passengers.push_back(Passenger(name, age, gender, contact));
-                        index += 4;
-                    }
-                }
+Pnr pnrAtSecond(Pnr pnr, int secondOfDay) {
+    Pnr hhmmss = secondOfDay / 3600 * 10000 + secondOfDay / 60 % 60 * 100 + secondOfDay % 60;
+    return hhmmss * PNR_DATE_PART + pnr % PNR_DATE_PART;
+}
 
-                bookings.push_back(booking);
-            }
-        }
-        bookingFile.close();
+// In a sharded deployment each shard only issues PNRs whose second of day
+// is congruent to its index, so the router can tell the owner from the PNR
+int pnrShardIndex = 0;
+int pnrShardCount = 1;
+
+Pnr generateUniquePNR(const string& travelDate) {
+    Pnr pnr = parsePnr(generatePNR(travelDate));
+    int secondOfDay = pnrSecondOfDay(pnr);
+    secondOfDay += (pnrShardIndex - secondOfDay % pnrShardCount + pnrShardCount) % pnrShardCount;
+    if (secondOfDay >= 86400) secondOfDay = pnrShardIndex;
+    pnr = pnrAtSecond(pnr, secondOfDay);
+    for (int attempt = 0; attempt < 86400 && pnrIndex.count(pnr); attempt++) {
+        secondOfDay += pnrShardCount;
+        if (secondOfDay >= 86400) secondOfDay = pnrShardIndex;
+        pnr = pnrAtSecond(pnr, secondOfDay);
     }
+    return pnr;
 }
 
-// ==================== ADMIN FUNCTIONS ====================
+// Allocate seats and record the booking. If the run is full the booking
+// joins the waitlist when allowWaitlist is set, otherwise it is refused.
+// With a batch the journal record is queued there instead of written.
+bool commitBooking(Booking& booking, Train* train, bool allowWaitlist = false,
+                   vector<pair<string, string>>* batch = nullptr) {
+    TraceSpan span("passengerBookTicket.commit");
+    releasePastTrainRuns();
+    booking.bookedDay = lastRunSweepDay;    // The sweep keeps it at today
+    TrainRun* run = materializeTrainRun(*train, booking.date);
+    if (!run) return false;
+
+    if (allocateSeats(run, *train, booking, booking.seatNumbers)) {
+        addSegmentOccupancy(run, *train, booking, +1);
+        addPreferenceMeals(run, booking, +1);
+        booking.coach = booking.seatNumbers[0] / max(1, run->seats.seatsPerCoach) + 1;
+        booking.status = BOOKING_CONFIRMED;
+    } else if (allowWaitlist) {
+        booking.status = BOOKING_WAITLISTED;
+        run->joinWaitlist(bookings.size());
+    } else {
+        return false;
+    }
 
-void adminAddTrain() {
-    cout << "\n=== ADD NEW TRAIN ===\n";
+    run->bookingSlots.push_back((uint32_t)bookings.size());
+    appendBooking(booking);
+    if (batch) {
+        batch->push_back({"B", serializeBooking(booking)});
+    } else {
+        logMutation("B", serializeBooking(booking));
+    }
+    return true;
+}
 
-    string id, name, src, dest;
-    int seats;
+// ==================== CANCELLATION & WAITLIST ====================
 
-    cout << "Enter Train ID: ";
-    getline(cin, id);
-    cout << "Enter Train Name: ";
-    getline(cin, name);
-    cout << "Enter Source Station: ";
-    getline(cin, src);
-    cout << "Enter Destination: ";
-    getline(cin, dest);
+// Share of the fare refunded, by days left before travel
+double refundRate(int daysToTravel) {
+    if (daysToTravel > 7) return 0.9;
+    if (daysToTravel >= 2) return 0.75;
+    return 0.5;
+}
 
-    while (true) {
-        cout << "Enter Total Seats: ";
-        string seatsStr;
-        getline(cin, seatsStr);
-
-        if (isNumber(seatsStr)) {
-            seats = stoi(seatsStr);
-            if (seats > 0 && seats <= 2000) break;
-            else if (seats > 2000) cout << "Maximum 2000 seats allowed!\n";
-            else cout << "Seats must be positive!\n";
-        } else {
-            cout << "Invalid number! Please enter a valid integer.\n";
+// Promote waitlisted bookings, earliest first, while their whole group fits.
+// A group that does not fit blocks later ones so nobody is overtaken.
+int promoteWaitlist(TrainRun* run, vector<pair<string, string>>& records) {
+    Train* train = findTrain(run->trainId);
+    if (!train) return 0;
+
+    int promoted = 0;
+    while (!run->waitlist.empty()) {
+        size_t index = run->waitlist.top().bookingIndex;
+        if (bookings[index].status != BOOKING_WAITLISTED) {
+            run->waitlist.pop();    // Cancelled while waiting
+            continue;
         }
+
+        vector<int> seats;
+        if (!allocateSeats(run, *train, bookings[index], seats)) break;
+        run->waitlist.pop();
+
+        Booking& booking = bookings.mutate(index);
+        booking.seatNumbers = seats;
+        booking.coach = seats[0] / max(1, run->seats.seatsPerCoach) + 1;
+        booking.status = BOOKING_CONFIRMED;
+        addSegmentOccupancy(run, *train, booking, +1);
+        addMealDemand(run, index, +1);
+
+        string payload = formatPnr(booking.pnr) + "|" + to_string(seats.size());
+        for (int seat : seats) payload += "|" + to_string(seat);
+        records.push_back({"P", payload});
+        promoted++;
     }
+    return promoted;
+}
 
-    Train newTrain(id, name, src, dest, seats);
+// Cancel a booking, freeing its seats and refunding the fare, and confirm
+// the waitlisted bookings that now fit. The cancellation and promotions go
+// to the journal in one write before returning, so no later booking can be
+// journaled on the freed seats ahead of them. Returns false (with the
+// reason in error) if it cannot be cancelled.
+bool cancelBooking(size_t index, double& refund, string& error, int* promoted) {
+    const Booking& current = bookings[index];
+    if (journal.isFenced()) {
+        error = string(FENCED_ERROR) + ".";
+        return false;
+    }
+    if (current.status == BOOKING_CANCELLED) {
+        error = "Booking is already cancelled.";
+        return false;
+    }
 
-    // Add intermediate stations
-    cout << "\nAdd intermediate stations (type 'done' to finish):\n";
+    int daysToTravel = dayNumber(current.date) - todayDayNumber();
+    if (daysToTravel < 0) {
+        error = "Travel date has passed.";
+        return false;
+    }
 
-    int stationCount = 0;
-    while (true) {
-        cout << "\nStation " << (stationCount + 1) << " name (or 'done' to finish): ";
-        string station;
-        getline(cin, station);
+    Train* train = findTrain(current.trainId);
+    TrainRun* run = train ? findTrainRun(train->trainId, current.date) : nullptr;
+    cancellationModel.learn(current, true);
 
-        // Convert to lowercase for comparison
-        string stationLower = station;
-        transform(stationLower.begin(), stationLower.end(), stationLower.begin(), ::tolower);
+    Booking& booking = bookings.mutate(index);
+    if (booking.status == BOOKING_CONFIRMED && run) {
+        holdSeats(run, *train, booking, false);
+        addSegmentOccupancy(run, *train, booking, -1);
+        addMealDemand(run, index, -1);
+    }
 
-        if (stationLower == "done") {
-            cout << "Finished adding stations. Total stations added: " << stationCount << endl;
-            break;
-        }
+    // Waitlisted tickets never travelled, so they are refunded in full;
+    // catering is always refunded in full
+    refund = booking.status == BOOKING_WAITLISTED ? booking.fare : booking.fare * refundRate(daysToTravel);
+    refund += reverseCateringOrders(index, true, true);
+    booking.status = BOOKING_CANCELLED;
+    booking.refund = refund;
+    booking.seatNumbers.clear();
+
+    stringstream payload;
+    payload << formatPnr(booking.pnr) << "|" << refund;
+    vector<pair<string, string>> records = {{"X", payload.str()}};
+    int confirmed = run ? promoteWaitlist(run, records) : 0;
+    if (promoted) *promoted = confirmed;
+    logMutations(records);
+    return true;
+}
 
-        if (station.empty()) {
-            cout << "Station name cannot be empty! Please enter a valid name or 'done'.\n";
-            continue;
-        }
+string formatSeats(const Booking& booking, const Train* train) {
+    if (booking.seatNumbers.empty()) return "Not assigned";
+    string result;
+    for (size_t i = 0; i < booking.seatNumbers.size(); i++) {
+        if (i > 0) result += ", ";
+        result += train ? SeatMap::seatLabel(booking.seatNumbers[i], SeatMap::seatsPerCoachFor(train->totalSeats))
+                        : to_string(booking.seatNumbers[i] + 1);
+    }
+    return result;
+}
 
-        // Check if station already exists
-        bool duplicate = false;
-        if (station == src) {
-            cout << "Error: Station cannot be same as source station!\n";
-            duplicate = true;
-        }
-        if (station == dest) {
-            cout << "Error: Station cannot be same as destination station!\n";
-            duplicate = true;
-        }
-        for (const auto& existing : newTrain.stations) {
-            if (existing == station) {
-                cout << "Error: Station '" << station << "' already added!\n";
-                duplicate = true;
-                break;
-            }
-        }
+// Deduct pantry stock and add the order to the ledger; returns the bill
+double applyCateringOrder(size_t bookingIndex, CateringItem* item, int quantity) {
+    ScopedLatency latency(OP_CATERING_ORDER);
+    TraceSpan span("orderCatering");
 
-        if (duplicate) {
-            continue;
-        }
+    setPantryStock(item->itemId, pantryInventory[item->itemId] - quantity);
+    recordCateringOrder(bookingIndex, *item, quantity);
 
-        // Get distance from source
-        string distanceStr;
-        int distance;
-        while (true) {
-            cout << "Distance from " << src << " (km, typically 50-1500): ";
-            getline(cin, distanceStr);
+    const Booking& booking = bookings[bookingIndex];
+    TrainRun* run = findTrainRun(booking.trainId, booking.date);
+    if (run && booking.status == BOOKING_CONFIRMED) addOrderedMeal(run, cateringLedger[cateringLedger.size() - 1], +1);
+    logMutation("C", formatPnr(booking.pnr) + "|" + item->itemId + "|" + to_string(quantity));
+    return item->price * quantity;
+}
 
-            if (distanceStr.empty()) {
-                cout << "Distance cannot be empty!\n";
-                continue;
-            }
+// ==================== RESERVATION ENGINE API ====================
+//
+// Typed entry points for everything the console menus, the replay and
+// shard servers and bulk import do to the engine, declared in railway.h.
+// They never prompt or print; a failure is reported in the result's error
+// field. Callers that share the engine between threads hold engineMutex
+// around each call.
+
+// Empty if the request can be booked as far as train, stations, date and
+// group size go; otherwise the reason it cannot
+string validateBookingRequest(const BookingRequest& request, Train*& train) {
+    train = findTrain(request.trainId);
+    if (!train) return "Unknown train " + request.trainId;
+
+    int from = stationIndex(*train, request.source);
+    int to = stationIndex(*train, request.destination);
+    if (from < 0 || to < 0 || to <= from) return "Invalid stations for train " + request.trainId;
+
+    int travelDay = dayNumber(request.date);
+    int today = todayDayNumber();
+    if (travelDay < 0) return "Invalid travel date";
+    if (request.checkBookingWindow && (travelDay < today || travelDay > today + BOOKING_HORIZON_DAYS)) {
+        return "Travel date outside the booking window";
+    }
 
-            if (isNumber(distanceStr)) {
-                distance = stoi(distanceStr);
-                if (distance > 0 && distance <= 5000) {
-                    // Check if distance is logical (should be increasing)
-                    if (!newTrain.distances.empty() && distance <= newTrain.distances.back()) {
-                        cout << "Error: Distance must be greater than previous station (" 
-                             << newTrain.distances.back() << "km)!\n";
-                        continue;
-                    }
-                    break;
-                } else {
-                    cout << "Distance must be between 1 and 5000 km!\n";
-                }
-            } else {
-                cout << "Invalid number! Please enter a valid integer.\n";
-            }
-        }
+    if (request.passengers.empty()) return "No passengers";
+    if (request.passengers.size() > MAX_PASSENGERS_PER_BOOKING) {
+        return "More than " + to_string(MAX_PASSENGERS_PER_BOOKING) + " passengers";
+    }
+    return "";
+}
 
-        // Add station
-        newTrain.stations.push_back(station);
-        newTrain.distances.push_back(distance);
-        stationCount++;
+Booking bookingFromRequest(const BookingRequest& request) {
+    Booking booking(request.trainId, request.source, request.destination);
+    booking.date = request.date;
+    booking.mealPreference = request.mealPreference;
+    booking.passengers = request.passengers;
+    booking.pnr = request.pnr;
+    return booking;
+}
 
-        cout << "✓ Station '" << station << "' added at " << distance << "km from source.\n";
+// Fare, seats and meals for a booking without making it
+FareQuote quoteBooking(const BookingRequest& request) {
+    FareQuote quote;
+    Train* train;
+    quote.error = validateBookingRequest(request, train);
+    if (!quote.error.empty()) return quote;
+
+    Booking booking = bookingFromRequest(request);
+    quote.breakdown = priceBooking(booking, train);
+    quote.fare = booking.fare;
+    quote.seatsAvailable = availableSeatsBetween(train->trainId, request.date, request.source, request.destination);
+    if (request.mealPreference != MEAL_PREF_NONE) {
+        quote.mealsAvailable = availableMeals(request.mealPreference);
     }
+    quote.ok = true;
+    return quote;
+}
 
-    cout << "\nEnter Departure Time (HH:MM, 24-hour format): ";
-    getline(cin, newTrain.departureTime);
+// Price, seat and record a booking. With a batch the journal record is
+// queued there for one group commit.
+BookingResult bookTicket(const BookingRequest& request, vector<pair<string, string>>* journalBatch) {
+    BookingResult result;
+    Train* train;
+    result.error = journal.isFenced() ? FENCED_ERROR : validateBookingRequest(request, train);
+    if (!result.error.empty()) return result;
+
+    result.booking = bookingFromRequest(request);
+    if (!result.booking.pnr) result.booking.pnr = generateUniquePNR(result.booking.date);
+    result.breakdown = priceBooking(result.booking, train);
+    if (!commitBooking(result.booking, train, request.allowWaitlist, journalBatch)) {
+        result.error = request.allowWaitlist ? "Booking could not be completed" : "Not enough seats";
+        return result;
+    }
+    result.ok = true;
+    return result;
+}
 
-    cout << "Enter Arrival Time (HH:MM, 24-hour format): ";
-    getline(cin, newTrain.arrivalTime);
+BookingLookup lookupBooking(const string& pnr) {
+    BookingLookup lookup;
+    long slot = findBookingIndex(pnr);
+    if (slot < 0) {
+        lookup.error = "PNR not found";
+        return lookup;
+    }
+    lookup.booking = bookings[slot];
+    lookup.seats = formatSeats(lookup.booking, findTrain(lookup.booking.trainId));
+    cateringLedger.forBooking(slot, [&](const CateringOrderLine& line) {
+        const CateringItem& item = cateringMenu[line.itemSlot];
+        lookup.catering.push_back({item.name, item.type, line.quantity, line.price});
+        lookup.cateringTotal += line.price * line.quantity;
+    });
+    lookup.ok = true;
+    return lookup;
+}
 
-    string fareStr;
-    while (true) {
-        cout << "Enter Fare per KM (typical: 1.5 to 4.0): Rs.";
-        getline(cin, fareStr);
+string validateCateringBooking(const Booking& booking) {
+    if (booking.status != BOOKING_CONFIRMED) return "Catering can only be ordered on a confirmed booking";
+    if (dayNumber(booking.date) < todayDayNumber()) return "Travel date has passed";
+    return "";
+}
 
-        if (fareStr.empty()) {
-            cout << "Fare cannot be empty!\n";
-            continue;
-        }
+CateringResult placeCateringOrder(const string& pnr, const string& itemId, int quantity) {
+    CateringResult result;
+    long slot = findBookingIndex(pnr);
+    CateringItem* item = findCateringItem(itemId);
+    string bookingError = slot < 0 ? "PNR not found" : validateCateringBooking(bookings[slot]);
+    if (journal.isFenced()) {
+        result.error = FENCED_ERROR;
+    } else if (!bookingError.empty()) {
+        result.error = bookingError;
+    } else if (!item) {
+        result.error = "Invalid item " + itemId;
+    } else if (quantity <= 0) {
+        result.error = "Quantity must be positive";
+    } else if (quantity > pantryInventory[item->itemId]) {
+        result.error = "Only " + to_string(pantryInventory[item->itemId]) + " available";
+    }
+    if (!result.error.empty()) return result;
+
+    result.item = *item;
+    result.quantity = quantity;
+    result.amount = applyCateringOrder(slot, item, quantity);
+    result.bill = cateringBill(slot);
+    result.ok = true;
+    return result;
+}
 
-        if (isDouble(fareStr)) {
-            newTrain.farePerKm = stod(fareStr);
-            if (newTrain.farePerKm > 0 && newTrain.farePerKm <= 10.0) break;
-            else if (newTrain.farePerKm > 10.0) cout << "Fare per km is too high! Maximum Rs.10.0\n";
-            else cout << "Fare must be positive!\n";
-        } else {
-            cout << "Invalid fare! Please enter a valid number.\n";
+string validateTrain(const Train& train) {
+    if (train.trainId.empty()) return "Train ID cannot be empty";
+    if (findTrain(train.trainId)) return "Train " + train.trainId + " already exists";
+    if (train.source.empty() || train.destination.empty()) return "Source and destination are required";
+    if (train.source == train.destination) return "Source and destination cannot be the same";
+    if (train.totalSeats <= 0 || train.totalSeats > 2000) return "Seats must be between 1 and 2000";
+    if (train.farePerKm <= 0 || train.farePerKm > 10.0) return "Fare per km must be above 0 and at most Rs.10.0";
+    if (train.stations.size() != train.distances.size()) return "Every station needs a distance";
+    for (size_t i = 0; i < train.stations.size(); i++) {
+        const string& station = train.stations[i];
+        if (station.empty() || station == train.source || station == train.destination ||
+            find(train.stations.begin(), train.stations.begin() + i, station) != train.stations.begin() + i) {
+            return "Station '" + station + "' is empty or repeats another stop";
+        }
+        if (train.distances[i] <= 0 || train.distances[i] > 5000 ||
+            (i > 0 && train.distances[i] <= train.distances[i - 1])) {
+            return "Distances must increase along the route, up to 5000 km";
         }
     }
+    return "";
+}
 
-    trains.push_back(newTrain);
-    cout << "\n✅ Train added successfully!\n";
-    cout << "Train ID: " << newTrain.trainId << endl;
-    cout << "Train Name: " << newTrain.name << endl;
-    cout << "Route: " << newTrain.source;
-    for (int i = 0; i < newTrain.stations.size(); i++) {
-        cout << " -> " << newTrain.stations[i] << " (" << newTrain.distances[i] << "km)";
+AddTrainResult addTrain(const Train& train) {
+    AddTrainResult result;
+    result.error = journal.isFenced() ? FENCED_ERROR : validateTrain(train);
+    if (!result.error.empty()) return result;
+
+    trains.push_back(train);
+    stationDictionary.addTrain(train);
+    // Cached options are priced from network distances, which the train can
+    // shorten between stations it does not serve
+    if (stationNetwork.addTrain(train)) {
+        routeCache.clear();
+    } else {
+        routeCache.invalidateTrain(train);
     }
-    cout << " -> " << newTrain.destination << endl;
+    reportSnapshots.trainsChanged();
+    logMutation("T", serializeTrain(train));
 
-    // Calculate total distance
-    int totalDistance = 0;
-    if (!newTrain.distances.empty()) {
-        totalDistance = newTrain.distances.back();
-    }
-    cout << "Total distance: " << totalDistance << " km\n";
-    cout << "Total Seats: " << newTrain.totalSeats << endl;
-    cout << "Departure: " << newTrain.departureTime << endl;
-    cout << "Arrival: " << newTrain.arrivalTime << endl;
-    cout << "Fare per KM: Rs." << fixed << setprecision(2) << newTrain.farePerKm << endl;
-    cout << "Approx full journey fare: Rs." << fixed << setprecision(2) << (totalDistance * newTrain.farePerKm) << endl;
+    result.totalDistance = train.distances.empty() ? 0 : train.distances.back();
+    result.ok = true;
+    return result;
+}
 
-    saveToFile();
+// Percent chance the booking is cancelled, from the online model
+double predictCancellationProbability(const Booking& booking) {
+    return cancellationModel.score(cancelFeatures(booking)) * 100.0;
 }
 
-void adminViewTrains() {
-    cout << "\n=== ALL TRAINS ===\n";
-    if (trains.empty()) {
-        cout << "No trains available.\n";
-        return;
+// Finds the booking through the PNR index, like lookupBooking
+CancellationForecast predictCancellation(const string& pnr) {
+    CancellationForecast forecast;
+    long slot = findBookingIndex(pnr);
+    if (slot < 0) {
+        forecast.error = "PNR not found";
+        return forecast;
     }
+    forecast.booking = bookings[slot];
+    forecast.probability = predictCancellationProbability(forecast.booking);
+    forecast.outcomesLearned = cancellationModel.updates;
+    forecast.ok = true;
+    return forecast;
+}
 
-    cout << left << setw(10) << "Train ID" 
-         << setw(20) << "Name" 
-         << setw(15) << "Source" 
-         << setw(15) << "Destination" 
-         << setw(10) << "Seats" 
-         << setw(10) << "Fare/KM" 
-         << endl;
-    cout << string(80, '-') << endl;
+// Default menu, with the pantry stocked to each item's quantity
+void initializeCateringMenu() {
+    // Clear existing
+    cateringMenu.clear();
+    pantryInventory.clear();
+    fill(pantryByType, pantryByType + MEAL_TYPE_COUNT, 0);
 
-    for (auto &train : trains) {
-        cout << left << setw(10) << train.trainId 
-             << setw(20) << train.name 
-             << setw(15) << train.source 
-             << setw(15) << train.destination 
-             << setw(10) << train.totalSeats 
-             << fixed << setprecision(2)
-             << setw(10) << train.farePerKm 
-             << endl;
+    // Add sample items with realistic prices
+    cateringMenu.push_back(CateringItem("VEG001", "Vegetable Thali", "Veg", 120.0, 50));
+    cateringMenu.push_back(CateringItem("VEG002", "Vegetable Biryani", "Veg", 150.0, 30));
+    cateringMenu.push_back(CateringItem("VEG003", "Paneer Masala", "Veg", 180.0, 40));
+    cateringMenu.push_back(CateringItem("VEG004", "Dal Rice", "Veg", 80.0, 60));
+    cateringMenu.push_back(CateringItem("NV001", "Chicken Biryani", "Non-Veg", 200.0, 35));
+    cateringMenu.push_back(CateringItem("NV002", "Egg Curry", "Non-Veg", 100.0, 60));
+    cateringMenu.push_back(CateringItem("NV003", "Mutton Curry", "Non-Veg", 250.0, 25));
+    cateringMenu.push_back(CateringItem("BEV001", "Coffee", "Beverage", 30.0, 100));
+    cateringMenu.push_back(CateringItem("BEV002", "Tea", "Beverage", 20.0, 100));
+    cateringMenu.push_back(CateringItem("SNK001", "Chips", "Snack", 40.0, 80));
+
+    // Initialize inventory
+    for (auto &item : cateringMenu) {
+        setPantryStock(item.itemId, item.quantity);
     }
 }
 
-// ==================== PASSENGER FUNCTIONS ====================
-
-void passengerBookTicket() {
-    cout << "\n=== BOOK TICKET ===\n";
+bool setPantryQuantity(const string& itemId, int quantity, string& error) {
+    if (journal.isFenced()) {
+        error = FENCED_ERROR;
+        return false;
+    }
+    if (!findCateringItem(itemId)) {
+        error = "Unknown item " + itemId;
+        return false;
+    }
+    setPantryStock(itemId, quantity);
+    logMutation("I", itemId + "|" + to_string(quantity));
+    return true;
+}
 
-    if (trains.empty()) {
-        cout << "No trains available! Please ask admin to add trains first.\n";
-        return;
+bool resetCateringMenu(string& error) {
+    if (journal.isFenced()) {
+        error = FENCED_ERROR;
+        return false;
+    }
+    initializeCateringMenu();
+    for (auto &item : cateringMenu) {
+        logMutation("I", item.itemId + "|" + to_string(item.quantity));
     }
+    return true;
+}
 
-    // Show available trains
-    adminViewTrains();
+// ==================== QUERIES ====================
 
-    string trainId;
-    cout << "\nEnter Train ID: ";
-    getline(cin, trainId);
+size_t bookingCount() { return bookings.size(); }
 
-    // Find train
-    Train* selectedTrain = nullptr;
-    for (auto &train : trains) {
-        if (train.trainId == trainId) {
-            selectedTrain = &train;
-            break;
+Booking bookingAt(size_t slot) { return bookings[slot]; }
+
+int seatCapacity(const Train& train) { return SeatMap::capacityFor(train.totalSeats); }
+
+shared_ptr<const vector<Train>> reportTrains() {
+    return reportSnapshots.latest()->trains;
+}
+
+// Visits every booking of the latest view; returns how many there were
+size_t forEachReportBooking(const function<void(const Booking&)>& visit) {
+    shared_ptr<const ReportSnapshot> view = reportSnapshots.latest();
+    for (auto &booking : view->bookings) visit(booking);
+    return view->bookings.size();
+}
+
+void refreshReports() { reportSnapshots.refresh(); }
+
+vector<PantryLoad> pantryLoadingPlan() {
+    vector<const TrainRun*> runs;
+    for (auto &entry : trainRuns) runs.push_back(entry.second);
+    sort(runs.begin(), runs.end(), [](const TrainRun* a, const TrainRun* b) {
+        return a->travelDay != b->travelDay ? a->travelDay < b->travelDay : a->trainId < b->trainId;
+    });
+
+    vector<PantryLoad> plan;
+    for (const TrainRun* run : runs) {
+        PantryLoad load;
+        load.trainId = run->trainId;
+        load.date = run->date;
+        for (int t = 0; t < MEAL_TYPE_COUNT; t++) {
+            load.meals[t] = run->preferenceMeals[t] + run->orderedMeals[t];
         }
+        plan.push_back(load);
     }
+    return plan;
+}
 
-    if (!selectedTrain) {
-        cout << "Train not found!\n";
-        return;
+// One pass over the ledger
+size_t tallyCateringSales(vector<int>& sold, vector<double>& revenue) {
+    sold.assign(cateringMenu.size(), 0);
+    revenue.assign(cateringMenu.size(), 0.0);
+    for (size_t i = 0; i < cateringLedger.size(); i++) {
+        const CateringOrderLine& line = cateringLedger[i];
+        sold[line.itemSlot] += line.quantity;
+        revenue[line.itemSlot] += line.price * line.quantity;
     }
+    return cateringLedger.size();
+}
 
-    // Show available stations
-    cout << "\n📋 Available Stations: " << selectedTrain->source;
-    for (int i = 0; i < selectedTrain->stations.size(); i++) {
-        cout << " -> " << selectedTrain->stations[i];
-    }
-    cout << " -> " << selectedTrain->destination << endl;
+// ==================== BULK BOOKING IMPORT ====================
 
-    string source, dest;
-    cout << "Enter Boarding Station: ";
-    getline(cin, source);
-    cout << "Enter Destination Station: ";
-    getline(cin, dest);
+string trimField(const string& field) {
+    size_t begin = field.find_first_not_of(" \t\r");
+    if (begin == string::npos) return "";
+    size_t end = field.find_last_not_of(" \t\r");
+    return field.substr(begin, end - begin + 1);
+}
 
-    // Validate stations
-    bool validSource = (source == selectedTrain->source);
-    bool validDest = (dest == selectedTrain->destination);
+// Import travel-agent group bookings from a CSV file with one passenger per row:
+//   group,trainId,source,destination,date,meal,name,age,gender,contact
+// Rows sharing a group id form one booking. Every group is validated,
+// priced and seated in a single pass, and all accepted bookings are
+// written to the journal in one batch.
+ImportSummary importBookingsCsv(const string& path, vector<ImportRowResult>& results) {
+    TraceSpan span("importBookingsCsv");
+    ImportSummary summary = {0, 0, 0, 0.0};
+    results.clear();
+
+    ifstream in(path);
+    string line;
+    int lineNumber = 0;
+    vector<string> groupOrder;
+    unordered_map<string, vector<size_t>> rowsByGroup;      // group -> result rows
+    unordered_map<string, BookingRequest> requestByGroup;
+    unordered_map<string, int> invalidLineByGroup;          // group -> first rejected row
+
+    // A rejected row rejects its whole group
+    auto rejectRow = [&](ImportRowResult& row, const string& message) {
+        row.message = message;
+        if (!row.group.empty()) {
+            if (!rowsByGroup.count(row.group)) groupOrder.push_back(row.group);
+            rowsByGroup[row.group];     // Seen, even if none of its rows is valid
+            invalidLineByGroup.emplace(row.group, row.line);
+        }
+        results.push_back(row);
+    };
 
-    for (const auto& station : selectedTrain->stations) {
-        if (station == source) validSource = true;
-        if (station == dest) validDest = true;
-    }
+    while (getline(in, line)) {
+        lineNumber++;
+        if (trimField(line).empty()) continue;
 
-    if (!validSource || !validDest) {
-        cout << "Error: Invalid stations! Please check station names.\n";
-        return;
-    }
+        vector<string> fields;
+        stringstream ss(line);
+        string field;
+        while (getline(ss, field, ',')) fields.push_back(trimField(field));
 
-    if (source == dest) {
-        cout << "Error: Source and destination cannot be same!\n";
-        return;
-    }
+        if (lineNumber == 1 && !fields.empty() && fields[0] == "group") continue;   // Header
 
-    // Create booking
-    Booking newBooking(trainId, source, dest);
+        ImportRowResult row = {lineNumber, fields.empty() ? "" : fields[0], "Rejected", "", ""};
+        if (fields.size() < 10) {
+            rejectRow(row, "Expected 10 fields");
+            continue;
+        }
+        // At most 3 digits, so stoi cannot overflow on a long digit string
+        if (!isNumber(fields[7]) || fields[7].size() > 3 || stoi(fields[7]) < 1 || stoi(fields[7]) > 119) {
+            rejectRow(row, "Invalid age");
+            continue;
+        }
+        Gender gender;
+        uint64_t contact;
+        if (!parseGender(fields[8], gender)) {
+            rejectRow(row, "Invalid gender");
+            continue;
+        }
+        if (!parseContact(fields[9], contact)) {
+            rejectRow(row, "Invalid contact");
+            continue;
+        }
 
-    // Get travel date
-    string travelDate;
-    while (true) {
-        cout << "Enter travel date (DD-MM-YYYY, e.g., 15-12-2024): ";
-        getline(cin, travelDate);
-
-        // Basic date validation
-        if (travelDate.length() == 10 && 
-            travelDate[2] == '-' && travelDate[5] == '-') {
-            string dayStr = travelDate.substr(0, 2);
-            string monthStr = travelDate.substr(3, 2);
-            string yearStr = travelDate.substr(6, 4);
-
-            if (isNumber(dayStr) && isNumber(monthStr) && isNumber(yearStr)) {
-                int day = stoi(dayStr);
-                int month = stoi(monthStr);
-                int year = stoi(yearStr);
-
-                if (day >= 1 && day <= 31 && month >= 1 && month <= 12 && year >= 2024 && year <= 2030) {
-                    newBooking.date = travelDate;
-                    break;
-                }
-            }
+        const string& group = fields[0];
+        auto existing = requestByGroup.find(group);
+        if (existing == requestByGroup.end()) {
+            BookingRequest request;
+            request.trainId = fields[1];
+            request.source = fields[2];
+            request.destination = fields[3];
+            request.date = fields[4];
+            request.mealPreference = parseMealPreference(fields[5]);
+            request.allowWaitlist = false;
+            existing = requestByGroup.emplace(group, request).first;
+            if (!rowsByGroup.count(group)) groupOrder.push_back(group);
+        } else if (existing->second.trainId != fields[1] || existing->second.source != fields[2] ||
+                   existing->second.destination != fields[3] || existing->second.date != fields[4]) {
+            rejectRow(row, "Journey differs from the rest of the group");
+            continue;
         }
-        cout << "Invalid date format! Please use DD-MM-YYYY format.\n";
+
+        existing->second.passengers.push_back(Passenger(fields[6], stoi(fields[7]), gender, contact));
+        rowsByGroup[group].push_back(results.size());
+        results.push_back(row);
     }
 
-    // Generate PNR automatically with travel date
-    newBooking.pnr = generatePNR(newBooking.date);
+    vector<pair<string, string>> journalBatch;
 
-    // Add passengers
-    string numPassStr;
-    int numPassengers;
-    while (true) {
-        cout << "Number of passengers (1-6): ";
-        getline(cin, numPassStr);
-        if (isNumber(numPassStr)) {
-            numPassengers = stoi(numPassStr);
-            if (numPassengers > 0 && numPassengers <= 6) break;
-            else cout << "Please enter between 1 and 6 passengers.\n";
+    for (const auto& group : groupOrder) {
+        BookingResult result;
+        auto invalid = invalidLineByGroup.find(group);
+        if (invalid != invalidLineByGroup.end()) {
+            result.error = "Group rejected: line " + to_string(invalid->second) + " is invalid";
+        } else {
+            // Same pantry check as the console, against the stock left by
+            // the groups already booked
+            const BookingRequest& request = requestByGroup[group];
+            FareQuote quote = quoteBooking(request);
+            if (quote.ok && request.mealPreference != MEAL_PREF_NONE &&
+                quote.mealsAvailable < (int)request.passengers.size()) {
+                result.error = "Only " + to_string(max(0, quote.mealsAvailable)) + " " +
+                               mealPreferenceNames[request.mealPreference] + " meals available";
+            } else {
+                result = bookTicket(request, &journalBatch);
+            }
+        }
+        const string& error = result.error;
+        const Booking& booking = result.booking;
+
+        for (size_t rowIndex : rowsByGroup[group]) {
+            ImportRowResult& row = results[rowIndex];
+            if (error.empty()) {
+                row.status = "Booked";
+                row.pnr = formatPnr(booking.pnr);
+            } else {
+                row.message = error;
+            }
+        }
+
+        if (error.empty()) {
+            summary.groupsBooked++;
+            summary.passengers += booking.passengers.size();
+            summary.totalFare += booking.fare;
         } else {
-            cout << "Invalid number!\n";
+            summary.groupsRejected++;
         }
     }
 
-    for (int i = 0; i < numPassengers; i++) {
-        cout << "\nPassenger " << i + 1 << ":\n";
-        string name, gender, contact;
-        int age;
+    logMutations(journalBatch);
+    return summary;
+}
+
+bool writeImportReport(const string& path, const vector<ImportRowResult>& results) {
+    ofstream out(path);
+    if (!out.is_open()) return false;
+    out << "line,group,status,pnr,message\n";
+    for (auto &row : results) {
+        out << row.line << "," << row.group << "," << row.status << ","
+            << row.pnr << "," << row.message << "\n";
+    }
+    return true;
+}
+
+// ==================== MEMORY ACCOUNTING ====================
 
-        cout << "Name: ";
-        getline(cin, name);
+struct MemoryReportLine {
+    string structure;
+    size_t items;
+    MemoryUsage usage;
+};
 
-        string ageStr;
-        while (true) {
-            cout << "Age: ";
-            getline(cin, ageStr);
-            if (isNumber(ageStr)) {
-                age = stoi(ageStr);
-                if (age > 0 && age < 120) break;
-                else cout << "Please enter valid age (1-119).\n";
-            } else {
-                cout << "Invalid age!\n";
-            }
+template <typename Key>
+void accountIndex(MemoryUsage& usage, const unordered_map<Key, vector<size_t>>& index) {
+    usage.add(index);
+    for (auto &entry : index) usage.add(entry.second);
+}
+
+// Walks every major structure; cost is linear in the data, so call it from
+// reports rather than per operation
+vector<MemoryReportLine> measureMemory() {
+    vector<MemoryReportLine> report;
+
+    MemoryUsage trainUsage;
+    trainUsage.add(trains);
+    for (auto &train : trains) {
+        trainUsage.add(train.trainId);
+        trainUsage.add(train.name);
+        trainUsage.add(train.source);
+        trainUsage.add(train.destination);
+        trainUsage.add(train.stations);
+        for (auto &station : train.stations) trainUsage.add(station);
+        trainUsage.add(train.distances);
+        trainUsage.add(train.departureTime);
+        trainUsage.add(train.arrivalTime);
+    }
+    report.push_back({"trains", trains.size(), trainUsage});
+
+    MemoryUsage bookingUsage, passengerUsage;
+    size_t passengerCount = 0;
+    bookings.accountMemory(bookingUsage);
+    for (auto &booking : bookings) {
+        bookingUsage.add(booking.trainId);
+        bookingUsage.add(booking.source);
+        bookingUsage.add(booking.destination);
+        bookingUsage.add(booking.date);
+        bookingUsage.add(booking.seatNumbers);
+
+        passengerUsage.add(booking.passengers);
+        for (auto &passenger : booking.passengers) {
+            passengerUsage.add(passenger.name);
         }
+        passengerCount += booking.passengers.size();
+    }
+    report.push_back({"bookings", bookings.size(), bookingUsage});
+    report.push_back({"passengers", passengerCount, passengerUsage});
+
+    MemoryUsage indexUsage;
+    indexUsage.add(pnrIndex);
+    accountIndex(indexUsage, contactIndex);
+    accountIndex(indexUsage, nameIndex);
+    for (auto &entry : nameIndex) indexUsage.add(entry.first);
+    report.push_back({"booking_indexes", pnrIndex.size() + contactIndex.size() + nameIndex.size(), indexUsage});
+
+    MemoryUsage runUsage;
+    trainRunPool.accountMemory(runUsage);
+    runUsage.add(trainRuns);
+    for (auto &entry : trainRuns) runUsage.add(entry.first);
+    report.push_back({"train_runs", trainRunPool.live(), runUsage});
+
+    MemoryUsage ledgerUsage;
+    cateringLedger.accountMemory(ledgerUsage);
+    report.push_back({"catering_ledger", cateringLedger.size(), ledgerUsage});
+
+    MemoryUsage menuUsage;
+    menuUsage.add(cateringMenu);
+    for (auto &item : cateringMenu) {
+        menuUsage.add(item.itemId);
+        menuUsage.add(item.name);
+        menuUsage.add(item.type);
+    }
+    report.push_back({"catering_menu", cateringMenu.size(), menuUsage});
 
-        cout << "Gender (M/F/O): ";
-        getline(cin, gender);
-        cout << "Contact: ";
-        getline(cin, contact);
+    MemoryUsage pantryUsage;
+    pantryUsage.add(pantryInventory);
+    for (auto &entry : pantryInventory) pantryUsage.add(entry.first);
+    report.push_back({"pantry_inventory", pantryInventory.size(), pantryUsage});
+
+    MemoryUsage cacheUsage;
+    routeCache.accountMemory(cacheUsage);
+    report.push_back({"route_cache", routeCache.size(), cacheUsage});
+
+    MemoryUsage stationUsage;
+    stationDictionary.accountMemory(stationUsage);
+    report.push_back({"station_dictionary", stationDictionary.size(), stationUsage});
+
+    MemoryUsage networkUsage;
+    stationNetwork.accountMemory(networkUsage);
+    report.push_back({"station_distances", stationNetwork.size(), networkUsage});
+
+    return report;
+}
+
+string formatBytes(size_t bytes) {
+    stringstream ss;
+    if (bytes < 1024) ss << bytes << " B";
+    else if (bytes < 1024 * 1024) ss << fixed << setprecision(1) << bytes / 1024.0 << " KB";
+    else ss << fixed << setprecision(1) << bytes / (1024.0 * 1024.0) << " MB";
+    return ss.str();
+}
 
-        newBooking.passengers.push_back(Passenger(name, age, gender, contact));
+void printMemoryUsage(const vector<MemoryReportLine>& report) {
+    cout << "\nMemory usage (heap, estimated):\n";
+    cout << left << setw(20) << "Structure"
+         << right << setw(10) << "Items"
+         << setw(12) << "Bytes"
+         << setw(13) << "Allocations" << endl;
+    cout << string(55, '-') << endl;
+
+    MemoryUsage total;
+    for (auto &line : report) {
+        cout << left << setw(20) << line.structure
+             << right << setw(10) << line.items
+             << setw(12) << formatBytes(line.usage.bytes)
+             << setw(13) << line.usage.allocations << endl;
+        total += line.usage;
     }
+    cout << string(55, '-') << endl;
+    cout << left << setw(30) << "Total"
+         << right << setw(12) << formatBytes(total.bytes)
+         << setw(13) << total.allocations << endl;
+    cout << left;
+}
 
-    // Calculate fare based on actual distance
-    int distance = calculateRouteDistance(selectedTrain, source, dest);
-    newBooking.fare = distance * selectedTrain->farePerKm * numPassengers;
-
-    // Apply discounts for children and senior citizens
-    double discount = 0.0;
-    int children = 0, seniors = 0;
-    for (auto &passenger : newBooking.passengers) {
-        if (passenger.age < 5) {
-            discount += (distance * selectedTrain->farePerKm) * 1.0; // Free for <5
-            children++;
-        } else if (passenger.age <= 12) {
-            discount += (distance * selectedTrain->farePerKm) * 0.5; // 50% off for 5-12
-            children++;
-        } else if (passenger.age >= 60) {
-            discount += (distance * selectedTrain->farePerKm) * 0.4; // 40% off for seniors
-            seniors++;
-        }
+bool dumpMemoryUsage(const string& filename, const vector<MemoryReportLine>& report) {
+    ofstream out(filename);
+    if (!out.is_open()) return false;
+
+    MemoryUsage total;
+    out << "{\n  \"structures\": {\n";
+    for (size_t i = 0; i < report.size(); i++) {
+        const MemoryReportLine& line = report[i];
+        out << "    \"" << line.structure << "\": {\"items\": " << line.items
+            << ", \"bytes\": " << line.usage.bytes
+            << ", \"allocations\": " << line.usage.allocations << "}"
+            << (i + 1 < report.size() ? "," : "") << "\n";
+        total += line.usage;
     }
+    out << "  },\n  \"total\": {\"bytes\": " << total.bytes
+        << ", \"allocations\": " << total.allocations << "}\n}\n";
+    return out.good();
+}
 
-    newBooking.fare -= discount;
+// Each measures afresh, for front ends without the report type
+void printMemoryUsage() { printMemoryUsage(measureMemory()); }
 
-    // Ensure fare is not negative
-    if (newBooking.fare < 0) newBooking.fare = 0;
+bool dumpMemoryUsage(const string& filename) { return dumpMemoryUsage(filename, measureMemory()); }
 
-    // Meal preference
-    cout << "\nSelect meal preference for all passengers:\n";
-    cout << "1. Vegetarian\n2. Non-Vegetarian\n3. None\nChoice: ";
-    string mealChoiceStr;
-    getline(cin, mealChoiceStr);
+// ==================== LINE SOCKETS ====================
+
+// Endpoint given as "host:port"
+bool parseEndpoint(const string& text, string& host, int& port) {
+    size_t colon = text.rfind(':');
+    if (colon == string::npos || !isNumber(text.substr(colon + 1))) return false;
+    host = colon == 0 ? "127.0.0.1" : text.substr(0, colon);
+    port = stoi(text.substr(colon + 1));
+    return port > 0 && port < 65536;
+}
 
-    if (isNumber(mealChoiceStr)) {
-        int mealChoice = stoi(mealChoiceStr);
-        switch(mealChoice) {
-            case 1: newBooking.mealPreference = "Veg"; break;
-            case 2: newBooking.mealPreference = "Non-Veg"; break;
-            default: newBooking.mealPreference = "None";
+// TCP connection exchanging '\n' terminated text lines. Shards, the router
+// and remote replay all talk in session-recording lines ("BOOK|...") and
+// reply with a single "OK|..." or "ERR|..." line.
+class LineSocket {
+public:
+    LineSocket(int descriptor = -1) : fd(descriptor) {}
+    ~LineSocket() { close(); }
+    LineSocket(const LineSocket&) = delete;
+    LineSocket& operator=(const LineSocket&) = delete;
+
+    bool isOpen() const { return fd >= 0; }
+
+#ifdef RAILWAY_HAS_SOCKETS
+    bool connect(const string& host, int port) {
+        close();
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addresses = nullptr;
+        if (getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &addresses) != 0) return false;
+        for (addrinfo* a = addresses; a && fd < 0; a = a->ai_next) {
+            fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) != 0) close();
         }
-    } else {
-        newBooking.mealPreference = "None";
+        freeaddrinfo(addresses);
+        return fd >= 0;
     }
 
-    // Check pantry inventory
-    if (newBooking.mealPreference != "None") {
-        int availableMeals = 0;
-        for (auto &item : cateringMenu) {
-            if ((newBooking.mealPreference == "Veg" && item.type == "Veg") ||
-                (newBooking.mealPreference == "Non-Veg" && item.type == "Non-Veg")) {
-                availableMeals += pantryInventory[item.itemId];
+    bool readLine(string& line) {
+        while (true) {
+            size_t newline = buffer.find('\n');
+            if (newline != string::npos) {
+                line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                return true;
             }
+            char chunk[4096];
+            ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (received <= 0) return false;
+            buffer.append(chunk, received);
         }
+    }
 
-        if (availableMeals < numPassengers) {
-            cout << "\nWarning: Only " << availableMeals << " " 
-                 << newBooking.mealPreference << " meals available in pantry!\n";
-            cout << "Do you still want to proceed? (y/n): ";
-            string choice;
-            getline(cin, choice);
-            if (choice == "n" || choice == "N") {
-                newBooking.mealPreference = "None";
-            }
+    bool writeLine(const string& line) {
+        string data = line + "\n";
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += n;
         }
+        return true;
     }
 
-    bookings.push_back(newBooking);
-
-    cout << "\n=== BOOKING CONFIRMED ===\n";
-    cout << " PNR: " << newBooking.pnr << endl;
-    cout << " Train: " << selectedTrain->name << " (" << trainId << ")\n";
-    cout << " Route: " << source << " to " << dest << endl;
-    cout << " Travel Date: " << newBooking.date << endl;
-    cout << " Passengers: " << numPassengers;
-    if (children > 0) cout << " (" << children << " child" << (children > 1 ? "ren" : "") << ")";
-    if (seniors > 0) cout << " (" << seniors << " senior" << (seniors > 1 ? "s" : "") << ")";
-    cout << endl;
-    cout << " Distance: " << distance << " km\n";
-    cout << " Fare per km: Rs." << fixed << setprecision(2) << selectedTrain->farePerKm << endl;
-    cout << " Total Fare: Rs." << fixed << setprecision(2) << newBooking.fare << endl;
-    if (discount > 0) {
-        cout << " Discount applied: Rs." << fixed << setprecision(2) << discount << endl;
+    // Send one request and wait for its reply
+    bool call(const string& request, string& reply) {
+        return writeLine(request) && readLine(reply);
     }
-    cout << "  Meal Preference: " << newBooking.mealPreference << endl;
-    cout << "\n⚠️  IMPORTANT: Your PNR " << newBooking.pnr << " is for travel on " 
-         << newBooking.date << ". Keep it safe!\n";
-
-    saveToFile();
-}
 
-void passengerViewReservations() {
-    cout << "\n=== VIEW RESERVATIONS ===\n";
-
-    if (bookings.empty()) {
-        cout << "No reservations found.\n";
-        return;
+    void close() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        buffer.clear();
     }
 
-    string pnr;
-    cout << "Enter PNR Number: ";
-    getline(cin, pnr);
+    // Wake a thread blocked reading this connection; it sees end of stream
+    void shutdown() {
+        if (fd >= 0) ::shutdown(fd, SHUT_RDWR);
+    }
 
-    bool found = false;
-    for (auto &booking : bookings) {
-        if (booking.pnr == pnr) {
-            found = true;
-            cout << "\n=== RESERVATION DETAILS ===\n";
-            cout << " PNR: " << booking.pnr << endl;
-            cout << " Train ID: " << booking.trainId << endl;
-            cout << " Route: " << booking.source << " to " << booking.destination << endl;
-            cout << " Travel Date: " << booking.date << endl;
-            cout << " Fare: Rs." << fixed << setprecision(2) << booking.fare << endl;
-            cout << " Status: " << booking.status << endl;
-            cout << "  Meal: " << booking.mealPreference << endl;
-
-            cout << "\n Passengers (" << booking.passengers.size() << "):\n";
-            for (int i = 0; i < booking.passengers.size(); i++) {
-                cout << i+1 << ". " << booking.passengers[i].name 
-                     << " (" << booking.passengers[i].age << " years, " 
-                     << booking.passengers[i].gender << ") - "
-                     << booking.passengers[i].contact << endl;
-            }
-            break;
-        }
+    // readLine gives up (returns false) after this long without data
+    void setReadTimeout(int millis) {
+        timeval timeout = {millis / 1000, (millis % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
     }
+#else
+    bool connect(const string&, int) { return false; }
+    bool readLine(string&) { return false; }
+    bool writeLine(const string&) { return false; }
+    bool call(const string&, string&) { return false; }
+    void close() {}
+    void shutdown() {}
+    void setReadTimeout(int) {}
+#endif
+
+private:
+    int fd;
+    string buffer;
+};
 
-    if (!found) {
-        cout << "No reservation found with PNR: " << pnr << endl;
+#ifdef RAILWAY_HAS_SOCKETS
+// Listening socket on the loopback interface, or -1
+int listenOnPort(int port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (::bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || ::listen(fd, 64) != 0) {
+        ::close(fd);
+        return -1;
     }
+    return fd;
 }
 
-// ==================== FEATURE 4: CHEAPER ALTERNATIVE ROUTES ====================
-
-void suggestCheaperRoutes() {
-    cout << "\n=== CHEAPER ALTERNATIVE ROUTES ===\n";
-
-    if (trains.empty()) {
-        cout << "No trains available.\n";
-        return;
+// Accepts connections until stop is set (a handler sets it and shuts the
+// listening socket down), serving each on its own thread. Connections still
+// open at that point are shut down so their handlers return.
+template <typename Handler>
+void serveConnections(int listenFd, atomic<bool>& stop, Handler handle) {
+    vector<thread> connections;
+    mutex liveMutex;
+    vector<int> live;
+    while (!stop.load()) {
+        int client = ::accept(listenFd, nullptr, nullptr);
+        if (client < 0) continue;
+        {
+            lock_guard<mutex> lock(liveMutex);
+            live.push_back(client);
+        }
+        connections.push_back(thread([client, &handle, &liveMutex, &live]() {
+            LineSocket socket(client);
+            handle(socket);
+            lock_guard<mutex> lock(liveMutex);
+            live.erase(find(live.begin(), live.end(), client));
+        }));
     }
+    {
+        lock_guard<mutex> lock(liveMutex);
+        for (int fd : live) ::shutdown(fd, SHUT_RDWR);
+    }
+    for (auto &connection : connections) connection.join();
+    ::close(listenFd);
+}
 
-    string source, dest;
-    cout << "Enter Source Station: ";
-    getline(cin, source);
-    cout << "Enter Destination Station: ";
-    getline(cin, dest);
+// Makes a blocked accept() return so the serving loop can see stop
+void stopListening(int listenFd, atomic<bool>& stop) {
+    stop = true;
+    ::shutdown(listenFd, SHUT_RDWR);
+}
+#endif
 
-    if (source == dest) {
-        cout << "Source and destination cannot be same!\n";
-        return;
+string joinFields(const vector<string>& tokens) {
+    string line;
+    for (size_t i = 0; i < tokens.size(); i++) {
+        if (i > 0) line += "|";
+        line += tokens[i];
     }
+    return line;
+}
 
-    vector<pair<double, Train*>> alternatives;
+// ==================== SESSION REPLAY LOAD GENERATOR ====================
 
-    for (auto &train : trains) {
-        bool hasSource = false;
-        bool hasDest = false;
+struct ReplayOperation {
+    uint64_t offsetMicros;
+    vector<string> tokens;   // tokens[0] is the operation name
+};
 
-        // Check source
-        if (train.source == source) hasSource = true;
-        if (train.destination == dest) hasDest = true;
+LatencyRegistry replayLatency;
 
-        // Check intermediate stations
-        for (const auto& station : train.stations) {
-            if (station == source) hasSource = true;
-            if (station == dest) hasDest = true;
+vector<ReplayOperation> loadSessionRecording(const string& path) {
+    vector<ReplayOperation> operations;
+    ifstream in(path);
+    string line;
+    while (getline(in, line)) {
+        if (line.empty()) continue;
+
+        vector<string> tokens;
+        stringstream ss(line);
+        string token;
+        while (getline(ss, token, '|')) {
+            tokens.push_back(token);
         }
 
-        if (hasSource && hasDest) {
-            // Calculate actual distance
-            int distance = calculateRouteDistance(&train, source, dest);
-            double fare = distance * train.farePerKm;
-            alternatives.push_back({fare, &train});
+        if (tokens.size() >= 2 && isNumber(tokens[0])) {
+            ReplayOperation op;
+            op.offsetMicros = stoull(tokens[0]);
+            op.tokens.assign(tokens.begin() + 1, tokens.end());
+            operations.push_back(op);
         }
     }
+    return operations;
+}
 
-    if (alternatives.empty()) {
-        cout << "\n❌ No direct routes found between " << source << " and " << dest << ".\n";
-        cout << " Try breaking journey into segments!\n";
-    } else {
-        // Sort by fare
-        sort(alternatives.begin(), alternatives.end());
-
-        cout << "\n=== AVAILABLE ROUTES (Sorted by Fare) ===\n";
-        cout << left << setw(10) << "Train ID" 
-             << setw(20) << "Train Name" 
-             << setw(15) << "Source" 
-             << setw(15) << "Destination" 
-             << setw(10) << "Distance" 
-             << setw(15) << "Fare" 
-             << endl;
-        cout << string(85, '-') << endl;
-
-        for (auto &alt : alternatives) {
-            int distance = calculateRouteDistance(alt.second, source, dest);
-            cout << left << setw(10) << alt.second->trainId 
-                 << setw(20) << alt.second->name 
-                 << setw(15) << alt.second->source 
-                 << setw(15) << alt.second->destination 
-                 << setw(10) << distance << "km"
-                 << "Rs." << setw(12) << fixed << setprecision(2) << alt.first 
-                 << endl;
-        }
-
-        if (alternatives.size() > 1) {
-            double cheapest = alternatives[0].first;
-            double expensive = alternatives.back().first;
-            double savings = expensive - cheapest;
-            double savingsPercent = (savings / expensive) * 100;
+OperationType replayOperationType(const string& name) {
+    if (name == "BOOK" || name == "CANCEL") return OP_BOOKING;
+    if (name == "PNR") return OP_PNR_LOOKUP;
+    if (name == "CATER") return OP_CATERING_ORDER;
+    return OP_ROUTE_SEARCH;
+}
 
-            cout << "\n You can save up to Rs." << fixed << setprecision(2) << savings 
-                 << " (" << fixed << setprecision(1) << savingsPercent << "%) by choosing "
-                 << alternatives[0].second->name << "!\n";
-        }
+// BOOK|pnr|trainId|source|destination|date|meal|count|passengers...
+// The caller holds engineMutex. With a batch the journal record is queued
+// there for one group commit.
+string executeBooking(const vector<string>& t, vector<pair<string, string>>* batch = nullptr) {
+    ScopedLatency latency(OP_BOOKING);
+    BookingRequest request;
+    request.trainId = t[2];
+    request.source = t[3];
+    request.destination = t[4];
+    request.date = t[5];
+    // Recorded sessions carry their PNR, and their dates were valid when
+    // recorded, so they still replay once those dates have passed; new
+    // bookings get a PNR issued and must fall in the booking window
+    request.pnr = t[1].empty() ? 0 : parsePnr(t[1]);
+    request.checkBookingWindow = request.pnr == 0;
+    request.mealPreference = parseMealPreference(t[6]);
+
+    int passengerCount = isNumber(t[7]) ? stoi(t[7]) : 0;
+    size_t index = 8;
+    for (int i = 0; i < passengerCount && index + 3 < t.size(); i++) {
+        int age = isNumber(t[index + 1]) ? stoi(t[index + 1]) : 0;
+        Gender gender;
+        uint64_t contact;
+        if (!parseGender(t[index + 2], gender)) return "ERR|Invalid gender";
+        if (!parseContact(t[index + 3], contact)) return "ERR|Invalid contact";
+        request.passengers.push_back(Passenger(t[index], age, gender, contact));
+        index += 4;
     }
-}
 
-// ==================== FEATURE 5 & 7: CATERING & INVENTORY ====================
+    BookingResult result = bookTicket(request, batch);
+    if (!result.ok) return "ERR|" + result.error;
+    stringstream reply;
+    reply << "OK|" << formatPnr(result.booking.pnr) << "|" << formatBookingStatus(result.booking.status) << "|" << result.booking.fare;
+    return reply.str();
+}
 
-void initializeCateringMenu() {
-    // Clear existing
-    cateringMenu.clear();
-    pantryInventory.clear();
+// Executes one operation in session-recording form (BOOK, PNR, CATER, ROUTE,
+// CANCEL) against the engine. The caller holds engineMutex. Returns
+// "OK|<result fields>" or "ERR|<reason>"; shard servers send it as the reply.
+string executeRequest(const vector<string>& t) {
+    const string& op = t[0];
 
-    // Add sample items with realistic prices
-    cateringMenu.push_back(CateringItem("VEG001", "Vegetable Thali", "Veg", 120.0, 50));
-    cateringMenu.push_back(CateringItem("VEG002", "Vegetable Biryani", "Veg", 150.0, 30));
-    cateringMenu.push_back(CateringItem("VEG003", "Paneer Masala", "Veg", 180.0, 40));
-    cateringMenu.push_back(CateringItem("VEG004", "Dal Rice", "Veg", 80.0, 60));
-    cateringMenu.push_back(CateringItem("NV001", "Chicken Biryani", "Non-Veg", 200.0, 35));
-    cateringMenu.push_back(CateringItem("NV002", "Egg Curry", "Non-Veg", 100.0, 60));
-    cateringMenu.push_back(CateringItem("NV003", "Mutton Curry", "Non-Veg", 250.0, 25));
-    cateringMenu.push_back(CateringItem("BEV001", "Coffee", "Beverage", 30.0, 100));
-    cateringMenu.push_back(CateringItem("BEV002", "Tea", "Beverage", 20.0, 100));
-    cateringMenu.push_back(CateringItem("SNK001", "Chips", "Snack", 40.0, 80));
+    if (op == "BOOK" && t.size() >= 8) return executeBooking(t);
 
-    // Initialize inventory
-    for (auto &item : cateringMenu) {
-        pantryInventory[item.itemId] = item.quantity;
+    if (op == "PNR" && t.size() >= 2) {
+        const Booking* booking = findBookingByPnr(t[1]);
+        return booking ? "OK|" + serializeBooking(*booking) : "ERR|PNR not found";
     }
-}
 
-void viewCateringMenu() {
-    cout << "\n=== CATERING MENU ===\n";
-    if (cateringMenu.empty()) {
-        cout << "Menu is empty. Please initialize catering menu from admin.\n";
-        return;
+    if (op == "CATER" && t.size() >= 4) {
+        if (!isNumber(t[3])) return "ERR|Invalid quantity";
+        CateringResult order = placeCateringOrder(t[1], t[2], stoi(t[3]));
+        if (!order.ok) return "ERR|" + order.error;
+        stringstream reply;
+        reply << "OK|" << order.amount;
+        return reply.str();
     }
 
-    cout << left << setw(10) << "Item ID" 
-         << setw(25) << "Item Name" 
-         << setw(15) << "Type" 
-         << setw(10) << "Price" 
-         << setw(10) << "Available" 
-         << endl;
-    cout << string(70, '-') << endl;
+    if (op == "ROUTE" && t.size() >= 3) {
+        // OK|count then trainId|name|fare|distance per option, cheapest first;
+        // with a travel date the fares include demand pricing
+        vector<RouteOption> options = quoteRoutes(t[1], t[2], t.size() >= 4 ? t[3] : "");
+        stringstream reply;
+        reply << "OK|" << options.size();
+        for (auto &option : options) {
+            const Train& train = trains[option.trainIndex];
+            reply << "|" << train.trainId << "|" << train.name << "|" << option.fare << "|" << option.distance;
+        }
+        return reply.str();
+    }
 
-    for (auto &item : cateringMenu) {
-        cout << left << setw(10) << item.itemId 
-             << setw(25) << item.name 
-             << setw(15) << item.type 
-             << "Rs." << setw(7) << fixed << setprecision(2) << item.price 
-             << setw(10) << pantryInventory[item.itemId] 
-             << endl;
+    if (op == "CANCEL" && t.size() >= 2) {
+        long bookingIndex = findBookingIndex(t[1]);
+        if (bookingIndex < 0) return "ERR|PNR not found";
+        double refund;
+        string error;
+        if (!cancelBooking(bookingIndex, refund, error)) return "ERR|" + error;
+        stringstream reply;
+        reply << "OK|" << refund;
+        return reply.str();
     }
+
+    return "ERR|Unknown request " + op;
 }
 
-void orderCatering() {
-    cout << "\n=== ORDER CATERING ===\n";
+// Rush mode (--rush QUEUE_LIMIT): when quota bookings open, requests for
+// the same train run would otherwise queue on the engine lock one by one.
+// Instead each run gets a bounded FIFO. A waiting thread becomes the
+// drainer when none is active, and commits up to RUSH_BATCH_LIMIT bookings
+// under a single engine lock and a single journal write. A full queue
+// rejects the request straight away rather than letting waits pile up.
+const size_t RUSH_BATCH_LIMIT = 64;
 
-    if (bookings.empty()) {
-        cout << "No bookings found. Please book a ticket first.\n";
-        return;
+class RushAdmission {
+public:
+    RushAdmission() {
+        queueLimit = 0;
+        admitted = rejected = batches = batchedBookings = 0;
+        maxDepth = 0;
     }
 
-    string pnr;
-    cout << "Enter PNR Number: ";
-    getline(cin, pnr);
+    bool isEnabled() const { return queueLimit > 0; }
+    void enable(size_t limit) { queueLimit = limit; }
 
-    // Find booking
-    Booking* booking = nullptr;
-    for (auto &b : bookings) {
-        if (b.pnr == pnr) {
-            booking = &b;
-            break;
+    // Blocks until the booking's batch has been committed; returns the reply
+    string submit(const vector<string>& request) {
+        Ticket ticket = {&request, "", false};
+        string key = request[2] + "|" + request[5];
+
+        unique_lock<mutex> lock(queueMutex);
+        RunQueue& queue = queues[key];
+        if (queue.pending.size() >= queueLimit) {
+            rejected++;
+            if (queue.pending.empty() && !queue.draining) queues.erase(key);
+            return "ERR|Rush queue full for train " + request[2] + " on " + request[5] + ", try again";
+        }
+        queue.pending.push_back(&ticket);
+        admitted++;
+        maxDepth = max(maxDepth, queue.pending.size());
+
+        while (!ticket.done) {
+            if (queue.draining) {
+                drained.wait(lock);
+                continue;
+            }
+            queue.draining = true;
+            size_t count = min(queue.pending.size(), RUSH_BATCH_LIMIT);
+            vector<Ticket*> batch(queue.pending.begin(), queue.pending.begin() + count);
+            queue.pending.erase(queue.pending.begin(), queue.pending.begin() + count);
+            lock.unlock();
+
+            commitBatch(batch);
+
+            lock.lock();
+            for (Ticket* t : batch) t->done = true;
+            queue.draining = false;
+            batches++;
+            batchedBookings += count;
+            drained.notify_all();
         }
+        // Waiting tickets keep the entry alive; the last one out drops it.
+        // Another drainer may already have, so look it up again.
+        auto it = queues.find(key);
+        if (it != queues.end() && it->second.pending.empty() && !it->second.draining) queues.erase(it);
+        return ticket.reply;
     }
 
-    if (!booking) {
-        cout << "Booking not found!\n";
-        return;
+    void printStats() {
+        lock_guard<mutex> lock(queueMutex);
+        if (!isEnabled()) return;
+        cout << "Rush admission: " << admitted << " admitted, " << rejected << " rejected (queue full), "
+             << batches << " batches";
+        if (batches > 0) cout << " averaging " << fixed << setprecision(1) << (double)batchedBookings / batches;
+        cout << ", deepest queue " << maxDepth << "/" << queueLimit << endl;
     }
 
-    cout << "Booking found: " << booking->trainId << " (" 
-         << booking->source << " to " << booking->destination << ")\n";
+private:
+    struct Ticket {
+        const vector<string>* request;
+        string reply;
+        bool done;
+    };
+
+    struct RunQueue {
+        deque<Ticket*> pending;
+        bool draining = false;
+    };
+
+    size_t queueLimit;
+    mutex queueMutex;
+    condition_variable drained;
+    unordered_map<string, RunQueue> queues;   // "trainId|date" -> waiting bookings
+    uint64_t admitted, rejected, batches, batchedBookings;
+    size_t maxDepth;
+
+    // Seat allocation for the whole batch in one critical section, in
+    // arrival order, followed by one journal group commit
+    void commitBatch(const vector<Ticket*>& batch) {
+        lock_guard<mutex> lock(engineMutex);
+        vector<pair<string, string>> records;
+        for (Ticket* ticket : batch) ticket->reply = executeBooking(*ticket->request, &records);
+        logMutations(records);
+        reportSnapshots.publishIfRequested();
+    }
+};
 
-    viewCateringMenu();
+RushAdmission rushAdmission;
 
-    string itemId;
-    string qtyStr;
-    int quantity;
+void enableRushAdmission(size_t limit) { rushAdmission.enable(limit); }
 
-    cout << "\nEnter Item ID to order: ";
-    getline(cin, itemId);
+// Runs one request from a replay worker or shard connection. Bookings go
+// through rush admission when it is on; everything else takes the engine
+// lock directly.
+string dispatchRequest(const vector<string>& t) {
+    if (rushAdmission.isEnabled() && t[0] == "BOOK" && t.size() >= 8) {
+        return rushAdmission.submit(t);
+    }
+    lock_guard<mutex> lock(engineMutex);
+    string reply = executeRequest(t);
+    reportSnapshots.publishIfRequested();
+    return reply;
+}
 
-    // Validate item ID
-    bool validItem = false;
-    CateringItem* selectedItem = nullptr;
-    for (auto &item : cateringMenu) {
-        if (item.itemId == itemId) {
-            validItem = true;
-            selectedItem = &item;
-            break;
-        }
+// Executes one recorded operation against the engine; false if it failed
+bool replayOperation(const vector<string>& t) {
+    return dispatchRequest(t).compare(0, 3, "OK|") == 0;
+}
+
+// Report reader used during replay: scans the latest published view,
+// counting seats held by confirmed bookings, without taking the engine lock
+size_t scanConfirmedPassengers(const ReportSnapshot& view) {
+    size_t passengers = 0;
+    for (auto &booking : view.bookings) {
+        if (booking.status == BOOKING_CONFIRMED) passengers += booking.passengers.size();
     }
+    return passengers;
+}
 
-    if (!validItem) {
-        cout << "Invalid Item ID!\n";
-        return;
+// Drive a recorded session from several threads. Operations on the same PNR
+// stay on one thread so a booking is always replayed before its lookups and
+// catering orders. speed 1 = original pacing, 10 = ten times faster,
+// 0 = as fast as possible.
+// readerCount report readers scan published snapshots meanwhile. With a
+// remote endpoint ("host:port" of a shard or router) operations are sent
+// over the network instead of run in this process.
+int runReplay(const string& path, int threadCount, double speed, int readerCount,
+              const string& remote) {
+    string remoteHost;
+    int remotePort = 0;
+    if (!remote.empty() && !parseEndpoint(remote, remoteHost, remotePort)) {
+        cout << "Error: Invalid endpoint " << remote << " (expected host:port)\n";
+        return 1;
     }
 
-    while (true) {
-        cout << "Enter Quantity (max " << pantryInventory[itemId] << "): ";
-        getline(cin, qtyStr);
-        if (isNumber(qtyStr)) {
-            quantity = stoi(qtyStr);
-            if (quantity > 0 && quantity <= pantryInventory[itemId]) break;
-            else if (quantity > pantryInventory[itemId]) {
-                cout << "Only " << pantryInventory[itemId] << " available!\n";
-            } else {
-                cout << "Quantity must be positive!\n";
-            }
+    vector<ReplayOperation> operations = loadSessionRecording(path);
+    if (operations.empty()) {
+        cout << "No operations found in " << path << endl;
+        return 1;
+    }
+    if (threadCount < 1) threadCount = 1;
+
+    vector<vector<const ReplayOperation*>> queues(threadCount);
+    size_t roundRobin = 0;
+    for (auto &op : operations) {
+        size_t target;
+        if (op.tokens[0] == "ROUTE" || op.tokens.size() < 2) {
+            target = roundRobin++ % threadCount;
         } else {
-            cout << "Invalid quantity!\n";
+            target = hash<string>()(op.tokens[1]) % threadCount;
         }
+        queues[target].push_back(&op);
     }
 
-    // Process order
-    pantryInventory[itemId] -= quantity;
-    selectedItem->quantity = pantryInventory[itemId];
-
-    double total = selectedItem->price * quantity;
-
-    cout << "\n✅ ORDER CONFIRMED\n";
-    cout << "================\n";
-    cout << "Item: " << selectedItem->name << " (" << selectedItem->type << ")\n";
-    cout << "Quantity: " << quantity << "\n";
-    cout << "Price per item: Rs." << fixed << setprecision(2) << selectedItem->price << "\n";
-    cout << "Total amount: Rs." << fixed << setprecision(2) << total << "\n";
-    cout << "Delivery: Will be served during the journey\n";
-
-    // Update booking meal preference
-    if (booking->mealPreference == "None") {
-        booking->mealPreference = selectedItem->type + " (" + to_string(quantity) + "x " + selectedItem->name + ")";
-    } else {
-        booking->mealPreference += ", " + selectedItem->type + " (" + to_string(quantity) + "x " + selectedItem->name + ")";
+    stringstream pace;
+    if (speed > 0) pace << speed << "x";
+    else pace << "full";
+    cout << "Replaying " << operations.size() << " operations from " << path
+         << " on " << threadCount << " thread(s) at " << pace.str() << " speed"
+         << (remote.empty() ? "" : " against " + remote) << "...\n";
+
+    atomic<uint64_t> failures(0);
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    uint64_t firstOffset = operations.front().offsetMicros;
+
+    vector<thread> workers;
+    for (int t = 0; t < threadCount; t++) {
+        workers.push_back(thread([&, t]() {
+            LineSocket link;
+            if (!remote.empty() && !link.connect(remoteHost, remotePort)) {
+                failures += queues[t].size();
+                return;
+            }
+            for (const ReplayOperation* op : queues[t]) {
+                if (speed > 0) {
+                    uint64_t offset = op->offsetMicros > firstOffset ? op->offsetMicros - firstOffset : 0;
+                    this_thread::sleep_until(begin + chrono::microseconds((uint64_t)(offset / speed)));
+                }
+                uint64_t start = nowNanos();
+                string reply;
+                bool ok = remote.empty() ? replayOperation(op->tokens)
+                                         : link.call(joinFields(op->tokens), reply) && reply.compare(0, 3, "OK|") == 0;
+                if (!ok) failures++;
+                replayLatency.record(replayOperationType(op->tokens[0]), nowNanos() - start);
+            }
+        }));
     }
 
-    cout << "\n📝 Note: Your meal preference has been updated.\n";
-
-    saveToFile();
-}
-
-void updateInventory() {
-    cout << "\n=== UPDATE CATERING INVENTORY ===\n";
-
-    viewCateringMenu();
+    // Report readers run alongside the workers on published snapshots
+    atomic<bool> replayDone(false);
+    atomic<uint64_t> reportScans(0);
+    atomic<size_t> lastViewBookings(0);
+    vector<thread> readers;
+    for (int r = 0; r < readerCount; r++) {
+        readers.push_back(thread([&]() {
+            while (!replayDone.load()) {
+                reportSnapshots.requestRefresh();
+                shared_ptr<const ReportSnapshot> view = reportSnapshots.acquire();
+                if (view) {
+                    scanConfirmedPassengers(*view);
+                    lastViewBookings = view->bookings.size();
+                    reportScans++;
+                }
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+        }));
+    }
 
-    string itemId;
-    string qtyStr;
-    int quantity;
+    for (auto &worker : workers) worker.join();
+    replayDone = true;
+    for (auto &reader : readers) reader.join();
 
-    cout << "\nEnter Item ID to update: ";
-    getline(cin, itemId);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
 
-    // Validate item ID
-    bool validItem = false;
-    CateringItem* selectedItem = nullptr;
-    for (auto &item : cateringMenu) {
-        if (item.itemId == itemId) {
-            validItem = true;
-            selectedItem = &item;
-            break;
-        }
+    cout << "\n=== REPLAY RESULTS ===\n";
+    cout << "Operations: " << operations.size() << " (" << failures.load() << " failed)\n";
+    cout << "Elapsed: " << fixed << setprecision(3) << seconds << " s\n";
+    cout << "Throughput: " << fixed << setprecision(1)
+         << (seconds > 0 ? operations.size() / seconds : 0.0) << " ops/s\n";
+    if (readerCount > 0) {
+        cout << "Report scans: " << reportScans.load() << " by " << readerCount
+             << " reader(s), last view " << lastViewBookings.load() << " bookings\n";
     }
+    rushAdmission.printStats();
+    printLatencyStats(replayLatency);
+    return 0;
+}
 
-    if (!validItem) {
-        cout << "Invalid Item ID!\n";
-        return;
-    }
+// ==================== SHARDING ====================
 
-    cout << "Current quantity: " << pantryInventory[itemId] << endl;
+// Trains, and the bookings on them, are partitioned across shard processes
+// by a hash of the train ID. Each shard is a normal engine with its own data
+// directory serving requests over a socket; the router forwards bookings to
+// the owning shard, finds a PNR's shard from the PNR itself and fans route
+// searches out to every shard.
 
-    while (true) {
-        cout << "Enter quantity to add (use negative to remove): ";
-        getline(cin, qtyStr);
-        if (isNumber(qtyStr)) {
-            quantity = stoi(qtyStr);
-            break;
-        } else {
-            cout << "Invalid quantity!\n";
-        }
+uint32_t hashTrainId(const string& trainId) {
+    uint32_t hash = 2166136261u;        // FNV-1a, stable across processes
+    for (unsigned char c : trainId) {
+        hash ^= c;
+        hash *= 16777619u;
     }
+    return hash;
+}
 
-    int newQuantity = pantryInventory[itemId] + quantity;
-    if (newQuantity < 0) {
-        cout << "Warning: Quantity cannot be negative! Setting to 0.\n";
-        newQuantity = 0;
-    }
+int shardForTrain(const string& trainId, int shardCount) {
+    return hashTrainId(trainId) % shardCount;
+}
 
-    pantryInventory[itemId] = newQuantity;
-    selectedItem->quantity = newQuantity;
+#ifdef RAILWAY_HAS_SOCKETS
+// Serve the loaded engine until a SHUTDOWN request arrives
+int runShardServer(int port) {
+    int listenFd = listenOnPort(port);
+    if (listenFd < 0) {
+        cout << "Error: Could not listen on port " << port << endl;
+        return 1;
+    }
+    cout << "Shard " << pnrShardIndex << " of " << pnrShardCount << ": " << trains.size()
+         << " trains, " << bookings.size() << " bookings, listening on port " << port << endl;
+
+    atomic<bool> stop(false);
+    serveConnections(listenFd, stop, [&](LineSocket& socket) {
+        string line;
+        vector<string> tokens;
+        while (socket.readLine(line)) {
+            splitFields(line.c_str(), line.c_str() + line.size(), tokens);
+            if (tokens.empty()) {
+                socket.writeLine("ERR|Empty request");
+                continue;
+            }
+            if (tokens[0] == "SHUTDOWN") {
+                socket.writeLine("OK");
+                stopListening(listenFd, stop);
+                return;
+            }
+            if (!socket.writeLine(dispatchRequest(tokens))) return;
+        }
+    });
 
-    cout << "\n✅ Inventory updated successfully!\n";
-    cout << "Item: " << selectedItem->name << endl;
-    cout << "New quantity: " << newQuantity << endl;
+    rushAdmission.printStats();
+    return 0;
 }
 
-// ==================== FEATURE 6: CANCELLATION PREDICTION ====================
-
-double predictCancellationProbability(const Booking& booking) {
-    // Simple prediction algorithm
-    double probability = 0.0;
+struct RoutedOption {
+    double fare;
+    string fields;      // trainId|name|fare|distance
+};
 
-    // Factor 1: Days until travel
-    int travelDay = 1, travelMonth = 1, travelYear = 2024;
-    if (booking.date.length() == 10 && booking.date[2] == '-' && booking.date[5] == '-') {
-        string dayStr = booking.date.substr(0, 2);
-        string monthStr = booking.date.substr(3, 2);
-        string yearStr = booking.date.substr(6, 4);
+int runRouter(int port, const vector<ShardEndpoint>& shards) {
+    int listenFd = listenOnPort(port);
+    if (listenFd < 0) {
+        cout << "Error: Could not listen on port " << port << endl;
+        return 1;
+    }
+    cout << "Router on port " << port << " for " << shards.size() << " shard(s)\n";
+
+    // PNR -> shard, learned from booking replies; PNRs from recorded sessions
+    // don't follow the shard numbering, so they are looked up this way
+    mutex ownerMutex;
+    unordered_map<Pnr, int> pnrOwner;
+    int shardCount = shards.size();
+
+    atomic<bool> stop(false);
+    serveConnections(listenFd, stop, [&](LineSocket& client) {
+        // Each client connection gets its own links to the shards
+        vector<unique_ptr<LineSocket>> links(shardCount);
+        auto forward = [&](int shard, const string& request, string& reply) {
+            if (!links[shard]) links[shard].reset(new LineSocket());
+            for (int attempt = 0; attempt < 2; attempt++) {
+                if (!links[shard]->isOpen() &&
+                    !links[shard]->connect(shards[shard].host, shards[shard].port)) {
+                    break;
+                }
+                if (links[shard]->call(request, reply)) return true;
+                links[shard]->close();
+            }
+            reply = "ERR|Shard " + to_string(shard) + " unavailable";
+            return false;
+        };
+
+        string line;
+        vector<string> t;
+        while (client.readLine(line)) {
+            splitFields(line.c_str(), line.c_str() + line.size(), t);
+            string reply;
+
+            if (t.empty()) {
+                reply = "ERR|Empty request";
+            } else if (t[0] == "SHUTDOWN") {
+                for (int shard = 0; shard < shardCount; shard++) forward(shard, "SHUTDOWN", reply);
+                client.writeLine("OK");
+                stopListening(listenFd, stop);
+                return;
+            } else if (t[0] == "BOOK" && t.size() >= 3) {
+                int shard = shardForTrain(t[2], shardCount);
+                if (forward(shard, line, reply) && reply.compare(0, 3, "OK|") == 0) {
+                    lock_guard<mutex> lock(ownerMutex);
+                    pnrOwner[parsePnr(reply.substr(3, PNR_DIGITS))] = shard;
+                }
+            } else if (t[0] == "ROUTE") {
+                vector<RoutedOption> options;
+                bool anyShard = false;
+                vector<string> fields;
+                for (int shard = 0; shard < shardCount; shard++) {
+                    string shardReply;
+                    if (!forward(shard, line, shardReply) || shardReply.compare(0, 3, "OK|") != 0) continue;
+                    anyShard = true;
+                    splitFields(shardReply.c_str(), shardReply.c_str() + shardReply.size(), fields);
+                    for (size_t i = 2; i + 3 < fields.size(); i += 4) {
+                        options.push_back({isDouble(fields[i + 2]) ? stod(fields[i + 2]) : 0.0,
+                                           fields[i] + "|" + fields[i + 1] + "|" + fields[i + 2] + "|" + fields[i + 3]});
+                    }
+                }
+                stable_sort(options.begin(), options.end(), [](const RoutedOption& a, const RoutedOption& b) {
+                    return a.fare < b.fare;
+                });
+                reply = anyShard ? "OK|" + to_string(options.size()) : "ERR|No shard available";
+                if (anyShard) {
+                    for (auto &option : options) reply += "|" + option.fields;
+                }
+            } else if ((t[0] == "PNR" || t[0] == "CANCEL" || t[0] == "CATER") && t.size() >= 2) {
+                Pnr pnr = parsePnr(t[1]);
+                int owner = -1;
+                {
+                    lock_guard<mutex> lock(ownerMutex);
+                    auto it = pnrOwner.find(pnr);
+                    if (it != pnrOwner.end()) owner = it->second;
+                }
+                // Try the known or numbered owner first, then the others
+                int first = owner >= 0 ? owner : pnrSecondOfDay(pnr) % shardCount;
+                for (int i = 0; i < shardCount; i++) {
+                    int shard = (first + i) % shardCount;
+                    forward(shard, line, reply);
+                    if (reply != "ERR|PNR not found") {
+                        if (owner < 0 && reply.compare(0, 3, "OK|") == 0) {
+                            lock_guard<mutex> lock(ownerMutex);
+                            pnrOwner[pnr] = shard;
+                        }
+                        break;
+                    }
+                    if (owner >= 0) break;
+                }
+            } else {
+                reply = "ERR|Unknown request " + t[0];
+            }
 
-        if (isNumber(dayStr) && isNumber(monthStr) && isNumber(yearStr)) {
-            travelDay = stoi(dayStr);
-            travelMonth = stoi(monthStr);
-            travelYear = stoi(yearStr);
+            if (!client.writeLine(reply)) return;
         }
-    }
+    });
+    return 0;
+}
 
-    // Get current date
-    time_t now = time(0);
-    tm* currentTime = localtime(&now);
-    int currentDay = currentTime->tm_mday;
-    int currentMonth = currentTime->tm_mon + 1;
-    int currentYear = currentTime->tm_year + 1900;
-
-    // Calculate days difference (simplified)
-    int daysDiff = 0;
-    if (travelYear == currentYear) {
-        daysDiff = (travelMonth - currentMonth) * 30 + (travelDay - currentDay);
-    } else {
-        daysDiff = (travelYear - currentYear) * 365 + (travelMonth - currentMonth) * 30 + (travelDay - currentDay);
+// Write shard0/ .. shard<N-1>/ data directories from the loaded state.
+// Each shard serves catering from its own pantry, so the stock is divided
+// rather than copied: every item is split in proportion to the seats on
+// each shard's trains (evenly if there are none), and the shares add up to
+// exactly the original stock.
+int splitIntoShards(int shardCount) {
+    vector<string> itemIds;
+    for (auto &item : cateringMenu) itemIds.push_back(item.itemId);
+
+    // seatsBefore[s] = seats on shards 0..s-1
+    vector<int64_t> seatsBefore(shardCount + 1, 0);
+    for (auto &train : trains) seatsBefore[shardForTrain(train.trainId, shardCount) + 1] += train.totalSeats;
+    for (int shard = 0; shard < shardCount; shard++) seatsBefore[shard + 1] += seatsBefore[shard];
+    if (seatsBefore[shardCount] == 0) {
+        for (int shard = 0; shard <= shardCount; shard++) seatsBefore[shard] = shard;
     }
+    auto pantryShare = [&](int stock, int shard) {
+        int64_t total = seatsBefore[shardCount];
+        return (int)(stock * seatsBefore[shard + 1] / total - stock * seatsBefore[shard] / total);
+    };
+
+    for (int shard = 0; shard < shardCount; shard++) {
+        string dir = "shard" + to_string(shard);
+        mkdir(dir.c_str(), 0755);
+
+        size_t trainCount = 0, bookingCount = 0;
+        bool ok = writeDataFile(dir + "/trains.dat", 0, [&](ofstream& out) {
+            for (auto &train : trains) {
+                if (shardForTrain(train.trainId, shardCount) != shard) continue;
+                out << serializeTrain(train) << "\n";
+                trainCount++;
+            }
+        });
+        ok = writeDataFile(dir + "/bookings.dat", 0, [&](ofstream& out) {
+            for (auto &booking : bookings) {
+                if (shardForTrain(booking.trainId, shardCount) != shard) continue;
+                out << serializeBooking(booking) << "\n";
+                bookingCount++;
+            }
+        }) && ok;
+        ok = writeDataFile(dir + "/catering.dat", 0, [&](ofstream& out) {
+            for (size_t i = 0; i < cateringLedger.size(); i++) {
+                const CateringOrderLine& line = cateringLedger[i];
+                const Booking& booking = bookings[line.bookingSlot];
+                if (shardForTrain(booking.trainId, shardCount) != shard) continue;
+                out << formatPnr(booking.pnr) << "|" << itemIds[line.itemSlot]
+                    << "|" << line.quantity << "|" << line.price << "\n";
+            }
+        }) && ok;
+        ok = writeDataFile(dir + "/pantry.dat", 0, [&](ofstream& out) {
+            for (auto &entry : pantryInventory) out << entry.first << "|" << pantryShare(entry.second, shard) << "\n";
+        }) && ok;
+
+        if (!ok) {
+            cout << "Error: Could not write " << dir << "/\n";
+            return 1;
+        }
+        cout << dir << "/: " << trainCount << " trains, " << bookingCount << " bookings\n";
+    }
+    return 0;
+}
+#endif
+
+// ==================== JOURNAL SHIPPING ====================
+//
+// A primary started with --replicate PORT streams its journal to warm
+// standbys (--standby host:port). A standby sends "FOLLOW" and receives:
+//   F|<file>|<lineCount>    followed by that many lines (base backup)
+//   E|<seq>                 base backup complete, it ends at journal seq
+//   R|<commitMillis>|<journal line>
+//   H|<primarySeq>|<sendMillis>   heartbeat, at least every 200 ms
+//   S|<primarySeq>          the primary is shutting down cleanly
+// and answers heartbeats with "ACK|<appliedSeq>". The standby writes the
+// records to its own journal as it applies them, so its data directory is
+// a copy of the primary's.
+//
+// After a clean shutdown the standby saves its copy and exits. If instead
+// the primary goes silent for STANDBY_TIMEOUT_MS or the connection drops,
+// the standby fences it before taking over: it reconnects and sends
+// "FENCE|<appliedSeq>", and the primary answers "FENCED|<seq>" after
+// closing its journal for good (only if the standby has every record) and
+// leaving fenced.marker so it will not start as a primary again. A primary
+// that cannot be reached is only replaced once the operator confirms it is
+// down.
+
+const char* REPLICATED_FILES[] = {"trains.dat", "bookings.dat", "pantry.dat", "catering.dat",
+                                  "cancel_model.dat", JOURNAL_PREV_FILE, JOURNAL_FILE};
+const char* FENCE_MARKER_FILE = "fenced.marker";
+
+bool isJournalFile(const char* name) {
+    return strcmp(name, JOURNAL_FILE) == 0 || strcmp(name, JOURNAL_PREV_FILE) == 0;
+}
+const int REPLICATION_HEARTBEAT_MS = 200;
+const int STANDBY_TIMEOUT_MS = 10 * REPLICATION_HEARTBEAT_MS;
+const int FENCE_ATTEMPTS = 5;
+const size_t MAX_STANDBY_QUEUE = 100000;    // Unsent records before a standby is dropped
+const int STANDBY_REPORT_SECONDS = 5;
+
+uint64_t wallClockMillis() {
+    return chrono::duration_cast<chrono::milliseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
+}
 
-    if (daysDiff < 0) daysDiff = 0;
-
-    if (daysDiff == 0) probability += 0.1;
-    else if (daysDiff <= 2) probability += 0.15;
-    else if (daysDiff <= 7) probability += 0.25;
-    else if (daysDiff <= 30) probability += 0.35;
-    else probability += 0.45;
+struct StandbyStatus {
+    int id;
+    uint64_t ackedSeq;
+    uint64_t lastAckMillis;
+    size_t queued;          // Records not yet sent
+};
 
-    // Factor 2: Group size
-    int groupSize = booking.passengers.size();
-    if (groupSize == 1) probability += 0.10;
-    else if (groupSize == 2) probability += 0.15;
-    else if (groupSize <= 4) probability += 0.20;
-    else probability += 0.25;
+#ifdef RAILWAY_HAS_SOCKETS
+class ReplicationHub {
+public:
+    ReplicationHub() {
+        listenFd = -1;
+        stop = false;
+        closing = false;
+        headSeq = 0;
+        nextId = 1;
+    }
 
-    // Factor 3: Fare amount
-    double farePerPerson = booking.fare / max(1, groupSize);
-    if (farePerPerson > 5000) probability += 0.20;
-    else if (farePerPerson > 2000) probability += 0.15;
-    else probability += 0.10;
+    ~ReplicationHub() { shutdown(); }
 
-    // Factor 4: Meal preference
-    if (booking.mealPreference != "None") probability -= 0.15;
+    bool isRunning() const { return listenFd >= 0; }
 
-    // Factor 5: Random factor
-    probability += (rand() % 20 - 10) / 100.0;
+    bool start(int port) {
+        if (!journal.isOpen()) return false;
+        listenFd = listenOnPort(port);
+        if (listenFd < 0) return false;
+        headSeq = journal.lastSequence();
+        journal.setTap([this](uint64_t seq, const string& line) { publish(seq, line); });
+        server = thread([this]() {
+            serveConnections(listenFd, stop, [this](LineSocket& socket) { serveStandby(socket); });
+        });
+        return true;
+    }
 
-    // Ensure between 0 and 1
-    probability = max(0.0, min(1.0, probability));
+    // Sends every queued record and a final "S" to each standby first, so
+    // they see a clean stop rather than a failure
+    void shutdown() {
+        if (listenFd < 0) return;
+        journal.setTap(nullptr);
+        {
+            unique_lock<mutex> lock(hubMutex);
+            closing = true;
+            wake.notify_all();
+            drained.wait_for(lock, chrono::milliseconds(STANDBY_TIMEOUT_MS), [this]() { return followers.empty(); });
+        }
+        stopListening(listenFd, stop);
+        wake.notify_all();
+        server.join();
+        listenFd = -1;
+    }
 
-    return probability * 100;
-}
+    uint64_t head() {
+        lock_guard<mutex> lock(hubMutex);
+        return headSeq;
+    }
 
-void viewCancellationPrediction() {
-    cout << "\n=== CANCELLATION PREDICTION ===\n";
+    vector<StandbyStatus> status() {
+        lock_guard<mutex> lock(hubMutex);
+        vector<StandbyStatus> result;
+        for (auto &follower : followers) {
+            result.push_back({follower->id, follower->ackedSeq.load(), follower->lastAckMillis.load(),
+                              follower->pending.size()});
+        }
+        return result;
+    }
 
-    if (bookings.empty()) {
-        cout << "No bookings found.\n";
-        return;
+private:
+    struct Follower {
+        int id;
+        LineSocket* socket;
+        deque<pair<uint64_t, string>> pending;   // commit millis, journal line
+        bool dropped;                            // Queue overflowed
+        atomic<uint64_t> ackedSeq;
+        atomic<uint64_t> lastAckMillis;
+    };
+
+    int listenFd;
+    atomic<bool> stop;
+    bool closing;           // Clean shutdown in progress
+    thread server;
+    mutex hubMutex;
+    condition_variable wake;
+    condition_variable drained;
+    list<shared_ptr<Follower>> followers;
+    uint64_t headSeq;
+    int nextId;
+
+    // Journal tap: runs under the journal lock, so records queue in order.
+    // A standby that stops reading is cut off once MAX_STANDBY_QUEUE records
+    // wait for it, rather than growing the queue without bound.
+    void publish(uint64_t seq, const string& line) {
+        lock_guard<mutex> lock(hubMutex);
+        headSeq = seq;
+        uint64_t now = wallClockMillis();
+        for (auto &follower : followers) {
+            if (follower->dropped) continue;
+            if (follower->pending.size() >= MAX_STANDBY_QUEUE) {
+                follower->dropped = true;
+                follower->pending.clear();
+                follower->socket->shutdown();   // Unblocks a stalled send
+                continue;
+            }
+            follower->pending.push_back({now, line});
+        }
+        wake.notify_all();
     }
 
-    string pnr;
-    cout << "Enter PNR Number: ";
-    getline(cin, pnr);
+    void serveStandby(LineSocket& socket) {
+        string hello;
+        if (!socket.readLine(hello)) return;
+        if (hello.compare(0, 6, "FENCE|") == 0 && isNumber(hello.substr(6))) {
+            fenceForStandby(socket, stoull(hello.substr(6)));
+            return;
+        }
+        if (hello != "FOLLOW") {
+            socket.writeLine("ERR|Expected FOLLOW");
+            return;
+        }
 
-    for (auto &booking : bookings) {
-        if (booking.pnr == pnr) {
-            double probability = predictCancellationProbability(booking);
-
-            cout << "\n=== PREDICTION RESULTS ===\n";
-            cout << "PNR: " << booking.pnr << endl;
-            cout << "Train: " << booking.trainId << endl;
-            cout << "Passengers: " << booking.passengers.size() << endl;
-            cout << "Total Fare: Rs." << fixed << setprecision(2) << booking.fare << endl;
-            cout << "Meal Preference: " << booking.mealPreference << endl;
-
-            cout << "\n Cancellation Probability: " << fixed << setprecision(1) 
-                 << probability << "%" << endl;
-
-            cout << "\nRisk Level: ";
-            if (probability < 20) {
-                cout << "🟢 VERY LOW (Highly likely to travel)\n";
-            } else if (probability < 40) {
-                cout << "🟡 LOW (Likely to travel)\n";
-            } else if (probability < 60) {
-                cout << "🟠 MEDIUM (Moderate cancellation risk)\n";
-            } else if (probability < 80) {
-                cout << "🔴 HIGH (Consider cancellation)\n";
-            } else {
-                cout << "🔴🔴 VERY HIGH (Very likely to cancel)\n";
+        // The data files only change at a checkpoint, which needs
+        // checkpointFilesMutex, so they are read while bookings go on. Only
+        // the journal files (about two checkpoint intervals of records at
+        // most) are read with appends held off, in the same step that
+        // starts queueing: every record after the base backup reaches the
+        // queue, none twice. The backup is sent after both locks are released.
+        auto follower = make_shared<Follower>();
+        vector<pair<string, string>> files;
+        uint64_t baseSeq = 0;
+        {
+            lock_guard<mutex> filesLock(checkpointFilesMutex);
+            for (const char* name : REPLICATED_FILES) {
+                string contents;
+                if (!isJournalFile(name) && readWholeFile(name, contents)) files.push_back({name, move(contents)});
             }
+            journal.paused([&](uint64_t lastSeq) {
+                baseSeq = lastSeq;
+                for (const char* name : REPLICATED_FILES) {
+                    string contents;
+                    if (isJournalFile(name) && readWholeFile(name, contents)) files.push_back({name, move(contents)});
+                }
+                lock_guard<mutex> lock(hubMutex);
+                follower->id = nextId++;
+                follower->socket = &socket;
+                follower->dropped = false;
+                follower->ackedSeq = 0;
+                follower->lastAckMillis = wallClockMillis();
+                followers.push_back(follower);
+            });
+        }
 
-            // Suggestions
-            cout << "\n💡 Recommendations:\n";
-            if (probability > 50) {
-                cout << "1. Consider flexible ticket options\n";
-                cout << "2. Set cancellation reminders\n";
-                cout << "3. Check refund policy (usually 50-90% refund)\n";
-                cout << "4. Consider travel insurance\n";
-                cout << "5. Monitor train status regularly\n";
-            } else {
-                cout << "1. You're likely to travel - prepare for journey\n";
-                cout << "2. Arrive at station 1 hour before departure\n";
-                cout << "3. Keep PNR and ID proof handy\n";
-                cout << "4. Check platform number before boarding\n";
+        bool ok = true;
+        for (auto &file : files) {
+            vector<string> lines;
+            stringstream ss(file.second);
+            string line;
+            while (getline(ss, line)) lines.push_back(line);
+            ok = ok && socket.writeLine("F|" + file.first + "|" + to_string(lines.size()));
+            for (size_t i = 0; ok && i < lines.size(); i++) ok = socket.writeLine(lines[i]);
+        }
+        ok = ok && socket.writeLine("E|" + to_string(baseSeq));
+
+        thread acks([&socket, follower]() {
+            string line;
+            while (socket.readLine(line)) {
+                if (line.compare(0, 4, "ACK|") == 0 && isNumber(line.substr(4))) {
+                    follower->ackedSeq = stoull(line.substr(4));
+                    follower->lastAckMillis = wallClockMillis();
+                }
             }
+        });
+
+        unique_lock<mutex> lock(hubMutex);
+        while (ok && !stop && !follower->dropped) {
+            wake.wait_for(lock, chrono::milliseconds(REPLICATION_HEARTBEAT_MS),
+                          [&]() { return stop.load() || closing || !follower->pending.empty(); });
+            deque<pair<uint64_t, string>> batch;
+            batch.swap(follower->pending);
+            uint64_t head = headSeq;
+            bool last = closing;
+            lock.unlock();
+
+            // One send for the whole batch and its heartbeat (or the final "S")
+            string data;
+            for (auto &record : batch) data += "R|" + to_string(record.first) + "|" + record.second + "\n";
+            data += last ? "S|" + to_string(head) : "H|" + to_string(head) + "|" + to_string(wallClockMillis());
+            ok = socket.writeLine(data);
+            lock.lock();
+            if (last) break;
+        }
+        followers.remove(follower);
+        drained.notify_all();
+        lock.unlock();
+        if (follower->dropped) {
+            cout << "\n[primary] Standby " << follower->id << " fell " << MAX_STANDBY_QUEUE
+                 << " records behind and was disconnected\n";
+        }
 
-            // Show confidence factors
-            cout << "\n📈 Key Factors Considered:\n";
-            cout << "- Group size: " << booking.passengers.size() << " passengers\n";
-            cout << "- Total fare: Rs." << fixed << setprecision(2) << booking.fare << endl;
-            cout << "- Meal preference: " << (booking.mealPreference != "None" ? "Set" : "Not set") << endl;
-            cout << "- Travel date: " << booking.date << endl;
+        socket.shutdown();
+        acks.join();
+    }
 
+    // A standby that lost us is taking over: stop writing for good if it
+    // has everything, and mark the data directory so it is not restarted
+    // as a primary
+    void fenceForStandby(LineSocket& socket, uint64_t standbySeq) {
+        uint64_t lastSeq = 0;
+        if (!journal.fence(standbySeq, lastSeq)) {
+            socket.writeLine("ERR|Standby is at seq " + to_string(standbySeq) + " but the primary is at " +
+                             to_string(lastSeq));
             return;
         }
+        ofstream marker(FENCE_MARKER_FILE);
+        marker << lastSeq << "\n";
+        marker.close();
+        socket.writeLine("FENCED|" + to_string(lastSeq));
+        cout << "\n[primary] Fenced at seq " << lastSeq << ": a standby has taken over. "
+             << "Changes are refused from now on.\n";
     }
+};
 
-    cout << "❌ Booking not found!\n";
+ReplicationHub replicationHub;
+
+void printReplicationStatus() {
+    if (!replicationHub.isRunning()) return;
+    vector<StandbyStatus> standbys = replicationHub.status();
+    uint64_t head = replicationHub.head();
+    cout << "Replication: journal at seq " << head << ", " << standbys.size() << " standby(s)\n";
+    uint64_t now = wallClockMillis();
+    for (auto &standby : standbys) {
+        cout << "  Standby " << standby.id << ": acked seq " << standby.ackedSeq
+             << ", " << (head > standby.ackedSeq ? head - standby.ackedSeq : 0) << " records behind, "
+             << standby.queued << " queued, last ack "
+             << (now > standby.lastAckMillis ? now - standby.lastAckMillis : 0) << " ms ago\n";
+    }
 }
 
-// ==================== MAIN MENU ====================
+// Replication lag as seen by a standby
+struct StandbyLag {
+    uint64_t appliedSeq = 0;
+    uint64_t primarySeq = 0;
+    uint64_t lastDelayMillis = 0;   // Commit on the primary to apply here
+    uint64_t maxDelayMillis = 0;
+    uint64_t applied = 0;
+
+    void print() const {
+        cout << "[standby] applied seq " << appliedSeq << ", primary at " << primarySeq << " ("
+             << (primarySeq > appliedSeq ? primarySeq - appliedSeq : 0) << " behind), "
+             << applied << " records applied, apply delay " << lastDelayMillis
+             << " ms (max " << maxDelayMillis << " ms)\n";
+    }
+};
+
+// Make sure a lost primary can no longer write before this standby takes
+// over. True once it has agreed to stop at appliedSeq, or when it cannot be
+// reached and confirmTakeover (the operator, from the console) says it is down.
+bool fencePrimary(const string& host, int port, uint64_t appliedSeq,
+                  const TakeoverConfirmation& confirmTakeover) {
+    for (int attempt = 0; attempt < FENCE_ATTEMPTS; attempt++) {
+        LineSocket socket;
+        string reply;
+        if (socket.connect(host, port)) socket.setReadTimeout(STANDBY_TIMEOUT_MS);
+        if (socket.isOpen() && socket.call("FENCE|" + to_string(appliedSeq), reply)) {
+            if (reply.compare(0, 7, "FENCED|") == 0) return true;
+            cout << "[standby] Primary refused to hand over: " << reply << endl;
+            return false;
+        }
+        this_thread::sleep_for(chrono::milliseconds(STANDBY_TIMEOUT_MS / 2));
+    }
+    cout << "[standby] Primary at " << host << ":" << port << " cannot be reached to fence it.\n";
+    return confirmTakeover && confirmTakeover(host, port);
+}
 
-void adminMenu() {
-    int choice;
-    do {
-        cout << "\n=== ADMIN MENU ===\n";
-        cout << "1. Add New Train\n";
-        cout << "2. View All Trains\n";
-        cout << "3. Update Catering Inventory\n";
-        cout << "4. View All Bookings\n";
-        cout << "5. Reset Catering Menu\n";
-        cout << "6. View System Stats\n";
-        cout << "7. Back to Main Menu\n";
-        cout << "Choice: ";
+// Take a base backup from the primary, then apply its journal until the
+// primary stops or is lost. Returns true when this process holds a
+// consistent copy and has fenced the old primary; the journal and
+// checkpointer are running by then.
+bool runStandby(const string& host, int port, const TakeoverConfirmation& confirmTakeover) {
+    // The base backup replaces these files, so never start on top of a data
+    // directory that has them (it could be the primary's own)
+    for (const char* name : REPLICATED_FILES) {
+        if (ifstream(name).is_open()) {
+            cout << "Error: " << name << " already exists here. Start a standby in an empty --data-dir.\n";
+            return false;
+        }
+    }
 
-        string choiceStr;
-        getline(cin, choiceStr);
+    LineSocket primary;
+    if (!primary.connect(host, port) || !primary.writeLine("FOLLOW")) {
+        cout << "Error: Could not reach primary at " << host << ":" << port << endl;
+        return false;
+    }
 
-        if (!isNumber(choiceStr)) {
-            cout << "Invalid choice! Please enter a number.\n";
-            continue;
+    string line;
+    uint64_t baseSeq = 0;
+    while (true) {
+        if (!primary.readLine(line)) {
+            cout << "Error: Primary closed the connection during the base backup\n";
+            return false;
+        }
+        vector<string> tokens;
+        splitFields(line.c_str(), line.c_str() + line.size(), tokens);
+        if (tokens.size() == 2 && tokens[0] == "E" && isNumber(tokens[1])) {
+            baseSeq = stoull(tokens[1]);
+            break;
+        }
+        const char* const* known = find_if(begin(REPLICATED_FILES), end(REPLICATED_FILES),
+                                           [&](const char* name) { return tokens.size() == 3 && tokens[1] == name; });
+        if (tokens[0] != "F" || known == end(REPLICATED_FILES) || !isNumber(tokens[2])) {
+            cout << "Error: Unexpected base backup line: " << line << endl;
+            return false;
         }
+        size_t count = stoull(tokens[2]);
+        string tmp = tokens[1] + ".tmp";
+        ofstream out(tmp);
+        for (size_t i = 0; i < count; i++) {
+            if (!primary.readLine(line)) {
+                cout << "Error: Primary closed the connection during the base backup\n";
+                return false;
+            }
+            out << line << "\n";
+        }
+        out.close();
+        if (!out.good() || rename(tmp.c_str(), tokens[1].c_str()) != 0) {
+            cout << "Error: Could not write " << tokens[1] << endl;
+            return false;
+        }
+    }
 
-        choice = stoi(choiceStr);
-
-        switch(choice) {
-            case 1: adminAddTrain(); break;
-            case 2: adminViewTrains(); break;
-            case 3: updateInventory(); break;
-            case 4: 
-                cout << "\n=== ALL BOOKINGS ===\n";
-                if (bookings.empty()) {
-                    cout << "No bookings yet.\n";
-                } else {
-                    cout << left << setw(15) << "PNR" 
-                         << setw(10) << "Train ID" 
-                         << setw(20) << "Route" 
-                         << setw(10) << "Passengers" 
-                         << setw(15) << "Fare" 
-                         << endl;
-                    cout << string(70, '-') << endl;
-
-                    for (auto &b : bookings) {
-                        string route = b.source + "-" + b.destination;
-                        cout << left << setw(15) << b.pnr 
-                             << setw(10) << b.trainId 
-                             << setw(20) << route 
-                             << setw(10) << b.passengers.size() 
-                             << "Rs." << setw(12) << fixed << setprecision(2) << b.fare 
-                             << endl;
-                    }
-                    cout << "\nTotal bookings: " << bookings.size() << endl;
-                }
-                break;
-            case 5: 
-                initializeCateringMenu();
-                cout << "✅ Catering menu reset to default.\n";
-                break;
-            case 6:
-                cout << "\n=== SYSTEM STATISTICS ===\n";
-                cout << "Trains in system: " << trains.size() << endl;
-                cout << "Total bookings: " << bookings.size() << endl;
-                cout << "Catering items: " << cateringMenu.size() << endl;
-                cout << "Data files: trains.dat, bookings.dat\n";
+    uint64_t appliedSeq = loadFromFile();
+    if (appliedSeq != baseSeq) {
+        cout << "Error: Base backup loads to seq " << appliedSeq << " but the primary is at " << baseSeq << endl;
+        return false;
+    }
+    if (!journal.open(appliedSeq + 1)) {
+        cout << "Error: Could not open " << JOURNAL_FILE << endl;
+        return false;
+    }
+    checkpointer.start();
+    cout << "[standby] " << trains.size() << " trains, " << bookings.size()
+         << " bookings at seq " << appliedSeq << ", following " << host << ":" << port << endl;
+
+    StandbyLag lag;
+    lag.appliedSeq = lag.primarySeq = appliedSeq;
+    uint64_t lastReport = wallClockMillis();
+    vector<string> tokens;
+    bool inSync = true;
+    bool primaryStopped = false;
+    primary.setReadTimeout(STANDBY_TIMEOUT_MS);
+    while (primary.readLine(line)) {
+        if (line.compare(0, 2, "R|") == 0) {
+            size_t bar = line.find('|', 2);
+            uint64_t seq;
+            char type;
+            if (bar == string::npos || !parseJournalLine(line.substr(bar + 1), seq, type, tokens)) continue;
+            if (seq != lag.appliedSeq + 1) {
+                cout << "Error: Journal gap, expected seq " << lag.appliedSeq + 1 << " but got " << seq << endl;
+                inSync = false;
                 break;
-            case 7: break;
-            default: cout << "Invalid choice!\n";
-        }
-    } while (choice != 7);
-}
-
-void passengerMenu() {
-    int choice;
-    do {
-        cout << "\n=== PASSENGER MENU ===\n";
-        cout << "1. Book Ticket\n";
-        cout << "2. View Reservation\n";
-        cout << "3. Suggest Cheaper Routes\n";
-        cout << "4. View Catering Menu\n";
-        cout << "5. Order Catering\n";
-        cout << "6. Check Cancellation Probability\n";
-        cout << "7. Back to Main Menu\n";
-        cout << "Choice: ";
-
-        string choiceStr;
-        getline(cin, choiceStr);
-
-        if (!isNumber(choiceStr)) {
-            cout << "Invalid choice! Please enter a number.\n";
-            continue;
+            }
+            // Same record, same sequence number in our own journal
+            applyJournalRecord(seq, type, tokens, 0, 0, 0, 0, 0);
+            journal.append(string(1, type), line.substr(line.find('|', bar + 1) + 3));
+            maybeCheckpoint();
+
+            uint64_t commitMillis = stoull(line.substr(2, bar - 2));
+            uint64_t now = wallClockMillis();
+            lag.lastDelayMillis = now > commitMillis ? now - commitMillis : 0;
+            lag.maxDelayMillis = max(lag.maxDelayMillis, lag.lastDelayMillis);
+            lag.appliedSeq = seq;
+            lag.primarySeq = max(lag.primarySeq, seq);
+            lag.applied++;
+        } else if (line.compare(0, 2, "H|") == 0) {
+            splitFields(line.c_str() + 2, line.c_str() + line.size(), tokens);
+            if (!tokens.empty() && isNumber(tokens[0])) lag.primarySeq = stoull(tokens[0]);
+            primary.writeLine("ACK|" + to_string(lag.appliedSeq));
+            if (wallClockMillis() - lastReport >= STANDBY_REPORT_SECONDS * 1000) {
+                lag.print();
+                lastReport = wallClockMillis();
+            }
+        } else if (line.compare(0, 2, "S|") == 0) {
+            primaryStopped = true;
+            break;
         }
+    }
+    primary.close();
+    lag.print();
+    if (primaryStopped) {
+        cout << "[standby] Primary shut down cleanly at seq " << lag.appliedSeq
+             << "; saving this copy and not taking over\n";
+        saveToFile();
+    } else if (inSync) {
+        cout << "[standby] Lost the primary at seq " << lag.appliedSeq << ", fencing it before taking over\n";
+    }
+    if (!inSync || primaryStopped || !fencePrimary(host, port, lag.appliedSeq, confirmTakeover)) {
+        checkpointer.stop();
+        return false;
+    }
 
-        choice = stoi(choiceStr);
-
-        switch(choice) {
-            case 1: passengerBookTicket(); break;
-            case 2: passengerViewReservations(); break;
-            case 3: suggestCheaperRoutes(); break;
-            case 4: viewCateringMenu(); break;
-            case 5: orderCatering(); break;
-            case 6: viewCancellationPrediction(); break;
-            case 7: break;
-            default: cout << "Invalid choice!\n";
-        }
-    } while (choice != 7);
+    // Promotion: derived state was left alone while following
+    cout << "[standby] Taking over at seq " << lag.appliedSeq << endl;
+    rebuildTrainRuns();
+    routeCache.clear();
+    stationDictionary.rebuild();
+    stationNetwork.rebuild(trains);
+    reportSnapshots.trainsChanged();
+    return true;
 }
+#endif
 
-int main() {
-    // Initialize data
-    cout << "=======================================\n";
-    cout << "   RAILWAY TICKET MANAGEMENT SYSTEM    \n";
-    cout << "=======================================\n";
-    cout << "Loading system data...\n";
-
-    loadFromFile();
+// Load the data files (or follow a primary until it goes away) and open
+// the journal; ship the journal to standbys when replicatePort is set
+bool startEngine(const string& standbyEndpoint, int replicatePort, const TakeoverConfirmation& confirmTakeover) {
     initializeCateringMenu();
-
-    srand(time(0));
-
-    cout << "✅ System initialized successfully!\n";
-    cout << "Trains loaded: " << trains.size() << endl;
-    cout << "Bookings loaded: " << bookings.size() << endl;
-    cout << "Catering items: " << cateringMenu.size() << endl;
-    cout << "=======================================\n";
-
-    int mainChoice;
-    do {
-        cout << "\n=== MAIN MENU ===\n";
-        cout << "1. Admin Login\n";
-        cout << "2. Passenger Portal\n";
-        cout << "3. View System Info\n";
-        cout << "4. Exit\n";
-        cout << "Choice: ";
-
-        string choiceStr;
-        getline(cin, choiceStr);
-
-        if (!isNumber(choiceStr)) {
-            cout << "Invalid choice! Please enter a number.\n";
-            continue;
+    if (!standbyEndpoint.empty()) {
+#ifdef RAILWAY_HAS_SOCKETS
+        string host;
+        int port = 0;
+        if (!parseEndpoint(standbyEndpoint, host, port)) {
+            cout << "Error: Invalid primary endpoint " << standbyEndpoint << " (expected host:port)\n";
+            return false;
         }
+        if (!runStandby(host, port, confirmTakeover)) return false;
+#else
+        cout << "Error: Standby mode needs POSIX sockets, which this platform does not provide.\n";
+        return false;
+#endif
+    } else {
+        ifstream marker(FENCE_MARKER_FILE);
+        uint64_t fencedSeq = 0;
+        if (marker >> fencedSeq) {
+            cout << "Error: This data directory was fenced at seq " << fencedSeq << " when its standby took over.\n"
+                 << "Follow the new primary with --standby in a fresh --data-dir instead.\n";
+            return false;
+        }
+        uint64_t lastSeq = loadFromFile();
+        if (!journal.open(lastSeq + 1)) {
+            cout << "Warning: Could not open " << JOURNAL_FILE << ", changes will only be saved on exit.\n";
+        }
+        checkpointer.start();
+    }
 
-        mainChoice = stoi(choiceStr);
-
-        switch(mainChoice) {
-            case 1: adminMenu(); break;
-            case 2: passengerMenu(); break;
-            case 3:
-                cout << "\n=== SYSTEM INFORMATION ===\n";
-                cout << "Railway Ticket Management System\n";
-                cout << "Version: 2.0\n";
-                cout << "Features included:\n";
-                cout << "1. Admin train management\n";
-                cout << "2. Passenger ticket booking with unique PNR\n";
-                cout << "3. Cheaper route suggestions\n";
-                cout << "4. Meal preferences & catering service\n";
-                cout << "5. Cancellation probability prediction\n";
-                cout << "6. Catering inventory management\n";
-                cout << "7. File-based data persistence\n";
-                cout << "\nCurrent stats:\n";
-                cout << "- Trains: " << trains.size() << endl;
-                cout << "- Bookings: " << bookings.size() << endl;
-                cout << "- Catering items: " << cateringMenu.size() << endl;
-                cout << "\nPress Enter to continue...";
-                cin.get();
-                break;
-            case 4: 
-                saveToFile();
-                cout << "\n✅ Data saved successfully!\n";
-                cout << "Thank you for using Railway Ticket System!\n";
-                cout << "Goodbye!\n";
-                break;
-            default: cout << "Invalid choice! Please enter 1-4.\n";
+    if (replicatePort > 0) {
+#ifdef RAILWAY_HAS_SOCKETS
+        if (replicationHub.start(replicatePort)) {
+            cout << "Shipping journal to standbys on port " << replicatePort << endl;
+        } else {
+            cout << "Warning: Could not start journal shipping on port " << replicatePort << endl;
         }
-    } while (mainChoice != 4);
+#else
+        cout << "Warning: Journal shipping needs POSIX sockets, which this platform does not provide.\n";
+#endif
+    }
+    return true;
+}
 
-    return 0;
+// Stop shipping before the final checkpoint so standbys see a clean end.
+// A fenced node keeps its files as they were at the fence.
+void stopEngine() {
+#ifdef RAILWAY_HAS_SOCKETS
+    replicationHub.shutdown();
+#endif
+    if (!journal.isFenced()) saveToFile();
+    checkpointer.stop();
 }
- 
- 
- 
- 
 
+#ifndef RAILWAY_HAS_SOCKETS
+void printReplicationStatus() {}
+#endif
+
+void printEngineStats() {
+    cout << "Train runs: " << trainRunPool.live() << " materialized, "
+         << trainRunPool.capacity() << " pooled\n";
+    cout << "Route cache: " << routeCache.size() << "/" << routeCache.maxSize()
+         << " entries, " << routeCache.hits << " hits, "
+         << routeCache.misses << " misses\n";
+    cout << "Station network: " << stationNetwork.size() << " stations, "
+         << stationNetwork.rowsComputed() << " distance rows computed\n";
+    cout << "Data files: trains.dat, bookings.dat, pantry.dat, catering.dat, cancel_model.dat, "
+         << JOURNAL_FILE << "\n";
+    cout << "Journal: " << journal.lastSequence() << " records written, "
+         << journal.recordsSinceRotation() << " since last checkpoint\n";
+    cout << "Cancellation model: " << cancellationModel.updates << " outcomes learned ("
+         << cancellationModel.cancellations << " cancelled)\n";
+    printReplicationStatus();
+    printLatencyStats();
+}
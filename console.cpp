@@ -0,0 +1,1443 @@
+// Console front end of the railway reservation engine: the admin and
+// passenger menus and the command line. All engine access goes through
+// railway.h.
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+
+#include "railway.h"
+
+#ifdef RAILWAY_HAS_SOCKETS
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// ==================== STATION PROMPTS ====================
+
+// Fixes the case of a known station, or offers matches for partial or
+// misspelt input. Returns the input unchanged if the user keeps it.
+string matchStation(const string& input, const vector<string>* allowed = nullptr) {
+    if (input.empty()) return input;
+
+    string exact = resolveStation(input);
+    if (!exact.empty() &&
+        (!allowed || find(allowed->begin(), allowed->end(), exact) != allowed->end())) {
+        return exact;
+    }
+
+    vector<string> candidates = stationCandidates(input, allowed);
+    if (candidates.empty()) return input;
+
+    cout << "Station '" << input << "' not found. Did you mean:\n";
+    for (size_t i = 0; i < candidates.size(); i++) {
+        cout << "  " << (i + 1) << ". " << candidates[i] << endl;
+    }
+    cout << "Choose 1-" << candidates.size() << " (0 to keep '" << input << "'): ";
+    string choice;
+    getline(cin, choice);
+    if (isNumber(choice)) {
+        int pick = stoi(choice);
+        if (pick >= 1 && pick <= (int)candidates.size()) return candidates[pick - 1];
+    }
+    return input;
+}
+
+string promptStation(const string& prompt, const vector<string>* allowed = nullptr) {
+    cout << prompt;
+    string input;
+    getline(cin, input);
+    return matchStation(input, allowed);
+}
+
+// ==================== ADMIN FUNCTIONS ====================
+
+void adminAddTrain() {
+    cout << "\n=== ADD NEW TRAIN ===\n";
+
+    string id, name, src, dest;
+    int seats;
+
+    cout << "Enter Train ID: ";
+    getline(cin, id);
+    if (findTrain(id)) {
+        cout << "Error: Train " << id << " already exists!\n";
+        return;
+    }
+    cout << "Enter Train Name: ";
+    getline(cin, name);
+    src = promptStation("Enter Source Station: ");
+    dest = promptStation("Enter Destination: ");
+
+    while (true) {
+        cout << "Enter Total Seats: ";
+        string seatsStr;
+        getline(cin, seatsStr);
+
+        if (isNumber(seatsStr)) {
+            seats = stoi(seatsStr);
+            if (seats > 0 && seats <= 2000) break;
+            else if (seats > 2000) cout << "Maximum 2000 seats allowed!\n";
+            else cout << "Seats must be positive!\n";
+        } else {
+            cout << "Invalid number! Please enter a valid integer.\n";
+        }
+    }
+
+    Train newTrain(id, name, src, dest, seats);
+
+    // Add intermediate stations
+    cout << "\nAdd intermediate stations (type 'done' to finish):\n";
+
+    int stationCount = 0;
+    while (true) {
+        cout << "\nStation " << (stationCount + 1) << " name (or 'done' to finish): ";
+        string station;
+        getline(cin, station);
+
+        // Convert to lowercase for comparison
+        string stationLower = station;
+        transform(stationLower.begin(), stationLower.end(), stationLower.begin(), ::tolower);
+
+        if (stationLower == "done") {
+            cout << "Finished adding stations. Total stations added: " << stationCount << endl;
+            break;
+        }
+
+        if (station.empty()) {
+            cout << "Station name cannot be empty! Please enter a valid name or 'done'.\n";
+            continue;
+        }
+        station = matchStation(station);
+
+        // Check if station already exists
+        bool duplicate = false;
+        if (station == src) {
+            cout << "Error: Station cannot be same as source station!\n";
+            duplicate = true;
+        }
+        if (station == dest) {
+            cout << "Error: Station cannot be same as destination station!\n";
+            duplicate = true;
+        }
+        for (const auto& existing : newTrain.stations) {
+            if (existing == station) {
+                cout << "Error: Station '" << station << "' already added!\n";
+                duplicate = true;
+                break;
+            }
+        }
+
+        if (duplicate) {
+            continue;
+        }
+
+        // Get distance from source
+        string distanceStr;
+        int distance;
+        while (true) {
+            cout << "Distance from " << src << " (km, typically 50-1500): ";
+            getline(cin, distanceStr);
+
+            if (distanceStr.empty()) {
+                cout << "Distance cannot be empty!\n";
+                continue;
+            }
+
+            if (isNumber(distanceStr)) {
+                distance = stoi(distanceStr);
+                if (distance > 0 && distance <= 5000) {
+                    // Check if distance is logical (should be increasing)
+                    if (!newTrain.distances.empty() && distance <= newTrain.distances.back()) {
+                        cout << "Error: Distance must be greater than previous station (" 
+                             << newTrain.distances.back() << "km)!\n";
+                        continue;
+                    }
+                    break;
+                } else {
+                    cout << "Distance must be between 1 and 5000 km!\n";
+                }
+            } else {
+                cout << "Invalid number! Please enter a valid integer.\n";
+            }
+        }
+
+        // Add station
+        newTrain.stations.push_back(station);
+        newTrain.distances.push_back(distance);
+        stationCount++;
+
+        cout << "✓ Station '" << station << "' added at " << distance << "km from source.\n";
+    }
+
+    cout << "\nEnter Departure Time (HH:MM, 24-hour format): ";
+    getline(cin, newTrain.departureTime);
+
+    cout << "Enter Arrival Time (HH:MM, 24-hour format): ";
+    getline(cin, newTrain.arrivalTime);
+
+    string fareStr;
+    while (true) {
+        cout << "Enter Fare per KM (typical: 1.5 to 4.0): Rs.";
+        getline(cin, fareStr);
+
+        if (fareStr.empty()) {
+            cout << "Fare cannot be empty!\n";
+            continue;
+        }
+
+        if (isDouble(fareStr)) {
+            newTrain.farePerKm = stod(fareStr);
+            if (newTrain.farePerKm > 0 && newTrain.farePerKm <= 10.0) break;
+            else if (newTrain.farePerKm > 10.0) cout << "Fare per km is too high! Maximum Rs.10.0\n";
+            else cout << "Fare must be positive!\n";
+        } else {
+            cout << "Invalid fare! Please enter a valid number.\n";
+        }
+    }
+
+    AddTrainResult added = addTrain(newTrain);
+    if (!added.ok) {
+        cout << "\nError: " << added.error << "!\n";
+        return;
+    }
+    cout << "\n✅ Train added successfully!\n";
+    cout << "Train ID: " << newTrain.trainId << endl;
+    cout << "Train Name: " << newTrain.name << endl;
+    cout << "Route: " << newTrain.source;
+    for (int i = 0; i < newTrain.stations.size(); i++) {
+        cout << " -> " << newTrain.stations[i] << " (" << newTrain.distances[i] << "km)";
+    }
+    cout << " -> " << newTrain.destination << endl;
+
+    int totalDistance = added.totalDistance;
+    cout << "Total distance: " << totalDistance << " km\n";
+    cout << "Total Seats: " << newTrain.totalSeats << endl;
+    cout << "Departure: " << newTrain.departureTime << endl;
+    cout << "Arrival: " << newTrain.arrivalTime << endl;
+    cout << "Fare per KM: Rs." << fixed << setprecision(2) << newTrain.farePerKm << endl;
+    cout << "Approx full journey fare: Rs." << fixed << setprecision(2) << (totalDistance * newTrain.farePerKm) << endl;
+}
+
+void adminBulkImport() {
+    cout << "\n=== BULK BOOKING IMPORT ===\n";
+    cout << "CSV columns: group,trainId,source,destination,date,meal,name,age,gender,contact\n";
+    cout << "Rows with the same group become one booking (max " << MAX_PASSENGERS_PER_BOOKING << " passengers).\n";
+
+    string path;
+    cout << "Enter CSV file path: ";
+    getline(cin, path);
+
+    ifstream check(path);
+    if (!check.is_open()) {
+        cout << "Error: Could not open " << path << endl;
+        return;
+    }
+    check.close();
+
+    vector<ImportRowResult> results;
+    ImportSummary summary = importBookingsCsv(path, results);
+
+    string reportPath = path + ".report.csv";
+    bool reportWritten = writeImportReport(reportPath, results);
+
+    cout << "\n✅ Import finished\n";
+    cout << "Groups booked: " << summary.groupsBooked << " (" << summary.passengers << " passengers)\n";
+    cout << "Groups rejected: " << summary.groupsRejected << endl;
+    cout << "Total fare: Rs." << fixed << setprecision(2) << summary.totalFare << endl;
+    for (auto &row : results) {
+        if (row.status != "Booked") {
+            cout << "  Line " << row.line << " (group " << row.group << "): " << row.message << endl;
+        }
+    }
+    if (reportWritten) {
+        cout << "Per-row report written to " << reportPath << endl;
+    } else {
+        cout << "Error: Could not write report " << reportPath << endl;
+    }
+}
+
+void adminViewTrains() {
+    cout << "\n=== ALL TRAINS ===\n";
+    shared_ptr<const vector<Train>> view = reportTrains();
+    const vector<Train>& trains = *view;
+    if (trains.empty()) {
+        cout << "No trains available.\n";
+        return;
+    }
+
+    cout << left << setw(10) << "Train ID" 
+         << setw(20) << "Name" 
+         << setw(15) << "Source" 
+         << setw(15) << "Destination" 
+         << setw(10) << "Seats" 
+         << setw(10) << "Fare/KM" 
+         << endl;
+    cout << string(80, '-') << endl;
+
+    for (auto &train : trains) {
+        cout << left << setw(10) << train.trainId 
+             << setw(20) << train.name 
+             << setw(15) << train.source 
+             << setw(15) << train.destination 
+             << setw(10) << train.totalSeats 
+             << fixed << setprecision(2)
+             << setw(10) << train.farePerKm 
+             << endl;
+    }
+}
+
+void adminPantryLoadingReport() {
+    cout << "\n=== PANTRY LOADING REPORT ===\n";
+
+    vector<PantryLoad> runs = pantryLoadingPlan();
+    if (runs.empty()) {
+        cout << "No upcoming departures with bookings.\n";
+        return;
+    }
+
+    cout << left << setw(10) << "Train ID" << setw(13) << "Date";
+    for (int t = 0; t < MEAL_TYPE_COUNT; t++) cout << setw(12) << mealTypeNames[t];
+    cout << endl;
+    cout << string(23 + 12 * MEAL_TYPE_COUNT, '-') << endl;
+
+    int totals[MEAL_TYPE_COUNT] = {};
+    for (const PantryLoad& run : runs) {
+        cout << left << setw(10) << run.trainId << setw(13) << run.date;
+        for (int t = 0; t < MEAL_TYPE_COUNT; t++) {
+            totals[t] += run.meals[t];
+            cout << setw(12) << run.meals[t];
+        }
+        cout << endl;
+    }
+    cout << string(23 + 12 * MEAL_TYPE_COUNT, '-') << endl;
+    cout << left << setw(23) << "Total to load";
+    for (int t = 0; t < MEAL_TYPE_COUNT; t++) cout << setw(12) << totals[t];
+    cout << endl;
+    cout << left << setw(23) << "Pantry stock";
+    for (int t = 0; t < MEAL_TYPE_COUNT; t++) cout << setw(12) << pantryByType[t];
+    cout << endl;
+    cout << "\nMeals include booked preferences and catering orders of confirmed passengers.\n";
+}
+
+void adminCateringSales() {
+    cout << "\n=== CATERING SALES ===\n";
+
+    vector<int> sold;
+    vector<double> revenue;
+    size_t orders = tallyCateringSales(sold, revenue);
+
+    cout << left << setw(10) << "Item ID"
+         << setw(22) << "Name"
+         << setw(8) << "Sold"
+         << setw(14) << "Revenue"
+         << setw(10) << "In Stock"
+         << endl;
+    cout << string(64, '-') << endl;
+
+    int totalSold = 0;
+    double totalRevenue = 0.0;
+    for (size_t i = 0; i < cateringMenu.size(); i++) {
+        const CateringItem& item = cateringMenu[i];
+        cout << left << setw(10) << item.itemId
+             << setw(22) << item.name
+             << setw(8) << sold[i]
+             << "Rs." << setw(11) << fixed << setprecision(2) << revenue[i]
+             << setw(10) << pantryInventory[item.itemId]
+             << endl;
+        totalSold += sold[i];
+        totalRevenue += revenue[i];
+    }
+    cout << string(64, '-') << endl;
+    cout << left << setw(32) << "Total" << setw(8) << totalSold
+         << "Rs." << fixed << setprecision(2) << totalRevenue << endl;
+    cout << "Orders in ledger: " << orders << endl;
+}
+
+// ==================== PASSENGER FUNCTIONS ====================
+
+void passengerBookTicket() {
+    cout << "\n=== BOOK TICKET ===\n";
+
+    if (trains.empty()) {
+        cout << "No trains available! Please ask admin to add trains first.\n";
+        return;
+    }
+
+    // Show available trains
+    adminViewTrains();
+
+    string trainId;
+    cout << "\nEnter Train ID: ";
+    getline(cin, trainId);
+
+    // Find train
+    Train* selectedTrain = findTrain(trainId);
+
+    if (!selectedTrain) {
+        cout << "Train not found!\n";
+        return;
+    }
+
+    // Show available stations
+    cout << "\n📋 Available Stations: " << selectedTrain->source;
+    for (int i = 0; i < selectedTrain->stations.size(); i++) {
+        cout << " -> " << selectedTrain->stations[i];
+    }
+    cout << " -> " << selectedTrain->destination << endl;
+
+    vector<string> routeStations = stationsOnRoute(*selectedTrain);
+    string source = promptStation("Enter Boarding Station: ", &routeStations);
+    string dest = promptStation("Enter Destination Station: ", &routeStations);
+
+    // Validate stations
+    bool validSource = (source == selectedTrain->source);
+    bool validDest = (dest == selectedTrain->destination);
+
+    for (const auto& station : selectedTrain->stations) {
+        if (station == source) validSource = true;
+        if (station == dest) validDest = true;
+    }
+
+    if (!validSource || !validDest) {
+        cout << "Error: Invalid stations! Please check station names.\n";
+        return;
+    }
+
+    if (source == dest) {
+        cout << "Error: Source and destination cannot be same!\n";
+        return;
+    }
+
+    // Create booking
+    BookingRequest request;
+    request.trainId = trainId;
+    request.source = source;
+    request.destination = dest;
+
+    // Get travel date
+    string travelDate;
+    while (true) {
+        cout << "Enter travel date (DD-MM-YYYY, e.g., 15-12-2024): ";
+        getline(cin, travelDate);
+
+        // Basic date validation
+        if (travelDate.length() == 10 && 
+            travelDate[2] == '-' && travelDate[5] == '-') {
+            string dayStr = travelDate.substr(0, 2);
+            string monthStr = travelDate.substr(3, 2);
+            string yearStr = travelDate.substr(6, 4);
+
+            if (isNumber(dayStr) && isNumber(monthStr) && isNumber(yearStr)) {
+                int day = stoi(dayStr);
+                int month = stoi(monthStr);
+                int year = stoi(yearStr);
+
+                if (day >= 1 && day <= 31 && month >= 1 && month <= 12 && year >= 2024 && year <= 2030) {
+                    int travelDay = dayNumber(travelDate);
+                    int today = todayDayNumber();
+                    if (travelDay < today) {
+                        cout << "Travel date cannot be in the past!\n";
+                        continue;
+                    }
+                    if (travelDay > today + BOOKING_HORIZON_DAYS) {
+                        cout << "Bookings open only " << BOOKING_HORIZON_DAYS << " days ahead!\n";
+                        continue;
+                    }
+                    request.date = travelDate;
+                    break;
+                }
+            }
+        }
+        cout << "Invalid date format! Please use DD-MM-YYYY format.\n";
+    }
+
+    // Generate PNR automatically with travel date
+    {
+        TraceSpan span("passengerBookTicket.pnr");
+        request.pnr = generateUniquePNR(request.date);
+    }
+
+    // Add passengers
+    string numPassStr;
+    int numPassengers;
+    while (true) {
+        cout << "Number of passengers (1-" << MAX_PASSENGERS_PER_BOOKING << "): ";
+        getline(cin, numPassStr);
+        if (isNumber(numPassStr)) {
+            numPassengers = stoi(numPassStr);
+            if (numPassengers > 0 && numPassengers <= (int)MAX_PASSENGERS_PER_BOOKING) break;
+            else cout << "Please enter between 1 and " << MAX_PASSENGERS_PER_BOOKING << " passengers.\n";
+        } else {
+            cout << "Invalid number!\n";
+        }
+    }
+
+    int freeSeats = availableSeatsBetween(trainId, request.date, source, dest);
+    if (freeSeats < numPassengers) {
+        cout << "Sorry, only " << freeSeats << " seat(s) left on this train!\n";
+        cout << "Join the waitlist? You will be confirmed automatically if seats are freed. (y/n): ";
+        string choice;
+        getline(cin, choice);
+        if (choice != "y" && choice != "Y") {
+            return;
+        }
+    }
+
+    for (int i = 0; i < numPassengers; i++) {
+        cout << "\nPassenger " << i + 1 << ":\n";
+        string name, gender, contact;
+        int age;
+
+        cout << "Name: ";
+        getline(cin, name);
+
+        string ageStr;
+        while (true) {
+            cout << "Age: ";
+            getline(cin, ageStr);
+            if (isNumber(ageStr)) {
+                age = stoi(ageStr);
+                if (age > 0 && age < 120) break;
+                else cout << "Please enter valid age (1-119).\n";
+            } else {
+                cout << "Invalid age!\n";
+            }
+        }
+
+        Gender genderCode;
+        while (true) {
+            cout << "Gender (M/F/O): ";
+            getline(cin, gender);
+            if (parseGender(gender, genderCode)) break;
+            cout << "Please enter M, F or O.\n";
+        }
+        uint64_t contactNumber;
+        while (true) {
+            cout << "Contact: ";
+            getline(cin, contact);
+            if (parseContact(contact, contactNumber)) break;
+            cout << "Please enter a phone number of up to 18 digits.\n";
+        }
+
+        request.passengers.push_back(Passenger(name, age, genderCode, contactNumber));
+    }
+
+    OperationTimer bookingTimer(OP_BOOKING);
+
+    // Meal preference
+    bookingTimer.pause();
+    cout << "\nSelect meal preference for all passengers:\n";
+    cout << "1. Vegetarian\n2. Non-Vegetarian\n3. None\nChoice: ";
+    string mealChoiceStr;
+    getline(cin, mealChoiceStr);
+    bookingTimer.resume();
+
+    if (isNumber(mealChoiceStr)) {
+        int mealChoice = stoi(mealChoiceStr);
+        switch(mealChoice) {
+            case 1: request.mealPreference = MEAL_PREF_VEG; break;
+            case 2: request.mealPreference = MEAL_PREF_NON_VEG; break;
+            default: request.mealPreference = MEAL_PREF_NONE;
+        }
+    } else {
+        request.mealPreference = MEAL_PREF_NONE;
+    }
+
+    // Check pantry inventory
+    if (request.mealPreference != MEAL_PREF_NONE) {
+        FareQuote quote = quoteBooking(request);
+
+        if (quote.ok && quote.mealsAvailable < numPassengers) {
+            cout << "\nWarning: Only " << quote.mealsAvailable << " " 
+                 << mealPreferenceNames[request.mealPreference] << " meals available in pantry!\n";
+            bookingTimer.pause();
+            cout << "Do you still want to proceed? (y/n): ";
+            string choice;
+            getline(cin, choice);
+            bookingTimer.resume();
+            if (choice == "n" || choice == "N") {
+                request.mealPreference = MEAL_PREF_NONE;
+            }
+        }
+    }
+
+    // Fare is based on the actual distance and the run's demand tier
+    BookingResult result = bookTicket(request);
+    if (!result.ok) {
+        bookingTimer.finish();
+        cout << "Sorry, your booking could not be completed: " << result.error << ".\n";
+        return;
+    }
+    bookingTimer.finish();
+    const Booking& newBooking = result.booking;
+    recordSessionBooking(newBooking);
+    int distance = result.breakdown.distance;
+    double discount = result.breakdown.discount;
+    int children = result.breakdown.children, seniors = result.breakdown.seniors;
+
+    if (newBooking.status == BOOKING_WAITLISTED) {
+        cout << "\n=== BOOKING WAITLISTED ===\n";
+    } else {
+        cout << "\n=== BOOKING CONFIRMED ===\n";
+    }
+    cout << " PNR: " << formatPnr(newBooking.pnr) << endl;
+    cout << " Train: " << selectedTrain->name << " (" << trainId << ")\n";
+    cout << " Route: " << source << " to " << dest << endl;
+    cout << " Travel Date: " << newBooking.date << endl;
+    cout << " Passengers: " << numPassengers;
+    if (children > 0) cout << " (" << children << " child" << (children > 1 ? "ren" : "") << ")";
+    if (seniors > 0) cout << " (" << seniors << " senior" << (seniors > 1 ? "s" : "") << ")";
+    cout << endl;
+    cout << " Seats: " << formatSeats(newBooking, selectedTrain) << endl;
+    cout << " Distance: " << distance << " km\n";
+    cout << " Fare per km: Rs." << fixed << setprecision(2) << selectedTrain->farePerKm << endl;
+    if (result.breakdown.tier->multiplier > 1.0) {
+        cout << " Demand pricing: " << result.breakdown.tier->name << " (x" << fixed << setprecision(2)
+             << result.breakdown.tier->multiplier << ")\n";
+    }
+    cout << " Total Fare: Rs." << fixed << setprecision(2) << newBooking.fare << endl;
+    if (discount > 0) {
+        cout << " Discount applied: Rs." << fixed << setprecision(2) << discount << endl;
+    }
+    cout << "  Meal Preference: " << mealPreferenceNames[newBooking.mealPreference] << endl;
+    cout << "\n⚠️  IMPORTANT: Your PNR " << formatPnr(newBooking.pnr) << " is for travel on " 
+         << newBooking.date << ". Keep it safe!\n";
+}
+
+void passengerViewReservations() {
+    cout << "\n=== VIEW RESERVATIONS ===\n";
+
+    if (bookingCount() == 0) {
+        cout << "No reservations found.\n";
+        return;
+    }
+
+    string pnr;
+    cout << "Enter PNR Number: ";
+    getline(cin, pnr);
+
+    BookingLookup lookup = lookupBooking(pnr);
+    recordSession("PNR", {pnr});
+
+    if (lookup.ok) {
+        const Booking& booking = lookup.booking;
+        cout << "\n=== RESERVATION DETAILS ===\n";
+        cout << " PNR: " << formatPnr(booking.pnr) << endl;
+        cout << " Train ID: " << booking.trainId << endl;
+        cout << " Route: " << booking.source << " to " << booking.destination << endl;
+        cout << " Travel Date: " << booking.date << endl;
+        cout << " Fare: Rs." << fixed << setprecision(2) << booking.fare << endl;
+        cout << " Status: " << formatBookingStatus(booking.status) << endl;
+        if (booking.status == BOOKING_CANCELLED) {
+            cout << " Refund: Rs." << fixed << setprecision(2) << booking.refund << endl;
+        }
+        cout << " Seats: " << lookup.seats << endl;
+        cout << "  Meal: " << mealPreferenceNames[booking.mealPreference] << endl;
+
+        if (!lookup.catering.empty()) {
+            cout << "  Catering Orders:\n";
+            for (auto &line : lookup.catering) {
+                cout << "    " << line.quantity << "x " << line.itemName << " (" << line.itemType << ") @ Rs."
+                     << fixed << setprecision(2) << line.price << endl;
+            }
+            cout << "  Catering Total: Rs." << fixed << setprecision(2) << lookup.cateringTotal << endl;
+        }
+
+        cout << "\n Passengers (" << booking.passengers.size() << "):\n";
+        for (int i = 0; i < booking.passengers.size(); i++) {
+            cout << i+1 << ". " << booking.passengers[i].name 
+                 << " (" << booking.passengers[i].age << " years, " 
+                 << formatGender(booking.passengers[i].gender) << ") - "
+                 << formatContact(booking.passengers[i].contact) << endl;
+        }
+    } else {
+        cout << "No reservation found with PNR: " << pnr << endl;
+    }
+}
+
+void passengerFindBookings() {
+    cout << "\n=== FIND MY BOOKINGS ===\n";
+    cout << "Search by:\n1. Contact number\n2. Passenger name\nChoice: ";
+    string choice;
+    getline(cin, choice);
+
+    vector<size_t> slots;
+    if (choice == "1") {
+        string contact;
+        cout << "Enter Contact: ";
+        getline(cin, contact);
+        slots = findBookingsByContact(contact);
+    } else if (choice == "2") {
+        string name;
+        cout << "Enter Passenger Name: ";
+        getline(cin, name);
+        slots = findBookingsByName(name);
+    } else {
+        cout << "Invalid choice!\n";
+        return;
+    }
+
+    if (slots.empty()) {
+        cout << "No bookings found.\n";
+        return;
+    }
+
+    cout << "\n" << left << setw(16) << "PNR"
+         << setw(10) << "Train ID"
+         << setw(24) << "Route"
+         << setw(13) << "Date"
+         << setw(12) << "Status"
+         << endl;
+    cout << string(75, '-') << endl;
+    for (size_t slot : slots) {
+        Booking b = bookingAt(slot);
+        cout << left << setw(16) << formatPnr(b.pnr)
+             << setw(10) << b.trainId
+             << setw(24) << (b.source + "-" + b.destination)
+             << setw(13) << b.date
+             << setw(12) << formatBookingStatus(b.status)
+             << endl;
+    }
+    cout << "\nFound " << slots.size() << " booking(s).\n";
+}
+
+void passengerCancelTicket() {
+    cout << "\n=== CANCEL TICKET ===\n";
+
+    string pnr;
+    cout << "Enter PNR Number: ";
+    getline(cin, pnr);
+
+    long bookingIndex = findBookingIndex(pnr);
+    if (bookingIndex < 0) {
+        cout << "Booking not found!\n";
+        return;
+    }
+
+    Booking booking = bookingAt(bookingIndex);
+    cout << "Booking found: " << booking.trainId << " (" << booking.source << " to "
+         << booking.destination << ") on " << booking.date << ", "
+         << booking.passengers.size() << " passenger(s), status " << formatBookingStatus(booking.status) << endl;
+    cout << "Fare paid: Rs." << fixed << setprecision(2) << booking.fare << endl;
+    cout << "Are you sure you want to cancel? (y/n): ";
+    string choice;
+    getline(cin, choice);
+    if (choice != "y" && choice != "Y") {
+        cout << "Cancellation aborted.\n";
+        return;
+    }
+
+    double refund;
+    string error;
+    int promoted = 0;
+    if (!cancelBooking(bookingIndex, refund, error, &promoted)) {
+        cout << "Error: " << error << endl;
+        return;
+    }
+    recordSession("CANCEL", {pnr});
+
+    cout << "\n✅ Ticket cancelled.\n";
+    cout << "Refund: Rs." << fixed << setprecision(2) << refund << endl;
+    if (promoted > 0) {
+        cout << promoted << " waitlisted booking(s) confirmed from the freed seats.\n";
+    }
+}
+
+void checkSeatAvailability() {
+    cout << "\n=== SEAT AVAILABILITY ===\n";
+
+    string trainId, date, from, to;
+    cout << "Enter Train ID: ";
+    getline(cin, trainId);
+
+    Train* train = findTrain(trainId);
+    if (!train) {
+        cout << "Train not found!\n";
+        return;
+    }
+
+    cout << "Enter travel date (DD-MM-YYYY): ";
+    getline(cin, date);
+    vector<string> routeStations = stationsOnRoute(*train);
+    from = promptStation("From Station: ", &routeStations);
+    to = promptStation("To Station: ", &routeStations);
+
+    int available = availableSeatsBetween(trainId, date, from, to);
+    if (available < 0) {
+        cout << "Error: Invalid stations! Please check station names and direction.\n";
+        return;
+    }
+
+    cout << "\nTrain " << train->name << " (" << trainId << ") on " << date << ":\n";
+    cout << from << " -> " << to << ": " << available << " of "
+         << seatCapacity(*train) << " seats available\n";
+}
+
+// ==================== FEATURE 4: CHEAPER ALTERNATIVE ROUTES ====================
+
+void suggestCheaperRoutes() {
+    cout << "\n=== CHEAPER ALTERNATIVE ROUTES ===\n";
+
+    if (trains.empty()) {
+        cout << "No trains available.\n";
+        return;
+    }
+
+    string source = promptStation("Enter Source Station: ");
+    string dest = promptStation("Enter Destination Station: ");
+
+    if (source == dest) {
+        cout << "Source and destination cannot be same!\n";
+        return;
+    }
+
+    string date;
+    cout << "Enter travel date (DD-MM-YYYY, blank for base fares): ";
+    getline(cin, date);
+
+    TraceSpan span("suggestCheaperRoutes");
+    vector<RouteOption> alternatives = quoteRoutes(source, dest, date);
+    recordSession("ROUTE", {source, dest, date});
+
+    if (alternatives.empty()) {
+        cout << "\n❌ No direct routes found between " << source << " and " << dest << ".\n";
+        cout << " Try breaking journey into segments!\n";
+    } else {
+        cout << "\n=== AVAILABLE ROUTES (Sorted by Fare) ===\n";
+        cout << left << setw(10) << "Train ID" 
+             << setw(20) << "Train Name" 
+             << setw(15) << "Source" 
+             << setw(15) << "Destination" 
+             << setw(10) << "Distance" 
+             << setw(15) << "Fare" 
+             << endl;
+        cout << string(85, '-') << endl;
+
+        for (auto &alt : alternatives) {
+            Train& train = trains[alt.trainIndex];
+            cout << left << setw(10) << train.trainId 
+                 << setw(20) << train.name 
+                 << setw(15) << train.source 
+                 << setw(15) << train.destination 
+                 << setw(10) << alt.distance << "km"
+                 << "Rs." << setw(12) << fixed << setprecision(2) << alt.fare 
+                 << endl;
+        }
+
+        if (alternatives.size() > 1) {
+            double cheapest = alternatives[0].fare;
+            double expensive = alternatives.back().fare;
+            double savings = expensive - cheapest;
+            double savingsPercent = (savings / expensive) * 100;
+
+            cout << "\n You can save up to Rs." << fixed << setprecision(2) << savings 
+                 << " (" << fixed << setprecision(1) << savingsPercent << "%) by choosing "
+                 << trains[alternatives[0].trainIndex].name << "!\n";
+        }
+    }
+}
+
+// ==================== FEATURE 5 & 7: CATERING & INVENTORY ====================
+
+void viewCateringMenu() {
+    cout << "\n=== CATERING MENU ===\n";
+    if (cateringMenu.empty()) {
+        cout << "Menu is empty. Please initialize catering menu from admin.\n";
+        return;
+    }
+
+    cout << left << setw(10) << "Item ID" 
+         << setw(25) << "Item Name" 
+         << setw(15) << "Type" 
+         << setw(10) << "Price" 
+         << setw(10) << "Available" 
+         << endl;
+    cout << string(70, '-') << endl;
+
+    for (auto &item : cateringMenu) {
+        cout << left << setw(10) << item.itemId 
+             << setw(25) << item.name 
+             << setw(15) << item.type 
+             << "Rs." << setw(7) << fixed << setprecision(2) << item.price 
+             << setw(10) << pantryInventory[item.itemId] 
+             << endl;
+    }
+}
+
+void orderCatering() {
+    cout << "\n=== ORDER CATERING ===\n";
+
+    if (bookingCount() == 0) {
+        cout << "No bookings found. Please book a ticket first.\n";
+        return;
+    }
+
+    string pnr;
+    cout << "Enter PNR Number: ";
+    getline(cin, pnr);
+
+    // Find booking
+    BookingLookup lookup = lookupBooking(pnr);
+
+    if (!lookup.ok) {
+        cout << "Booking not found!\n";
+        return;
+    }
+
+    string bookingError = validateCateringBooking(lookup.booking);
+    if (!bookingError.empty()) {
+        cout << "Error: " << bookingError << "!\n";
+        return;
+    }
+
+    cout << "Booking found: " << lookup.booking.trainId << " (" 
+         << lookup.booking.source << " to " << lookup.booking.destination << ")\n";
+
+    viewCateringMenu();
+
+    string itemId;
+    string qtyStr;
+    int quantity;
+
+    cout << "\nEnter Item ID to order: ";
+    getline(cin, itemId);
+
+    // Validate item ID
+    CateringItem* selectedItem = findCateringItem(itemId);
+
+    if (!selectedItem) {
+        cout << "Invalid Item ID!\n";
+        return;
+    }
+
+    while (true) {
+        cout << "Enter Quantity (max " << pantryInventory[itemId] << "): ";
+        getline(cin, qtyStr);
+        if (isNumber(qtyStr)) {
+            quantity = stoi(qtyStr);
+            if (quantity > 0 && quantity <= pantryInventory[itemId]) break;
+            else if (quantity > pantryInventory[itemId]) {
+                cout << "Only " << pantryInventory[itemId] << " available!\n";
+            } else {
+                cout << "Quantity must be positive!\n";
+            }
+        } else {
+            cout << "Invalid quantity!\n";
+        }
+    }
+
+    // Process order
+    CateringResult order = placeCateringOrder(pnr, itemId, quantity);
+    if (!order.ok) {
+        cout << "Error: " << order.error << "!\n";
+        return;
+    }
+    recordSession("CATER", {pnr, itemId, to_string(quantity)});
+
+    cout << "\n✅ ORDER CONFIRMED\n";
+    cout << "================\n";
+    cout << "Item: " << order.item.name << " (" << order.item.type << ")\n";
+    cout << "Quantity: " << order.quantity << "\n";
+    cout << "Price per item: Rs." << fixed << setprecision(2) << order.item.price << "\n";
+    cout << "Total amount: Rs." << fixed << setprecision(2) << order.amount << "\n";
+    cout << "Delivery: Will be served during the journey\n";
+
+    cout << "\n📝 Note: Catering bill for this booking is now Rs." << fixed << setprecision(2)
+         << order.bill << ".\n";
+}
+
+void updateInventory() {
+    cout << "\n=== UPDATE CATERING INVENTORY ===\n";
+
+    viewCateringMenu();
+
+    string itemId;
+    string qtyStr;
+    int quantity;
+
+    cout << "\nEnter Item ID to update: ";
+    getline(cin, itemId);
+
+    // Validate item ID
+    bool validItem = false;
+    CateringItem* selectedItem = nullptr;
+    for (auto &item : cateringMenu) {
+        if (item.itemId == itemId) {
+            validItem = true;
+            selectedItem = &item;
+            break;
+        }
+    }
+
+    if (!validItem) {
+        cout << "Invalid Item ID!\n";
+        return;
+    }
+
+    cout << "Current quantity: " << pantryInventory[itemId] << endl;
+
+    while (true) {
+        cout << "Enter quantity to add (use negative to remove): ";
+        getline(cin, qtyStr);
+        if (isNumber(qtyStr)) {
+            quantity = stoi(qtyStr);
+            break;
+        } else {
+            cout << "Invalid quantity!\n";
+        }
+    }
+
+    int newQuantity = pantryInventory[itemId] + quantity;
+    if (newQuantity < 0) {
+        cout << "Warning: Quantity cannot be negative! Setting to 0.\n";
+        newQuantity = 0;
+    }
+
+    string error;
+    if (!setPantryQuantity(itemId, newQuantity, error)) {
+        cout << "Error: " << error << "!\n";
+        return;
+    }
+
+    cout << "\n✅ Inventory updated successfully!\n";
+    cout << "Item: " << selectedItem->name << endl;
+    cout << "New quantity: " << newQuantity << endl;
+}
+
+// ==================== FEATURE 6: CANCELLATION PREDICTION ====================
+
+void viewCancellationPrediction() {
+    cout << "\n=== CANCELLATION PREDICTION ===\n";
+
+    if (bookingCount() == 0) {
+        cout << "No bookings found.\n";
+        return;
+    }
+
+    string pnr;
+    cout << "Enter PNR Number: ";
+    getline(cin, pnr);
+
+    CancellationForecast forecast = predictCancellation(pnr);
+    if (!forecast.ok) {
+        cout << "❌ Booking not found!\n";
+        return;
+    }
+
+    const Booking& booking = forecast.booking;
+    double probability = forecast.probability;
+
+    cout << "\n=== PREDICTION RESULTS ===\n";
+    cout << "PNR: " << formatPnr(booking.pnr) << endl;
+    cout << "Train: " << booking.trainId << endl;
+    cout << "Passengers: " << booking.passengers.size() << endl;
+    cout << "Total Fare: Rs." << fixed << setprecision(2) << booking.fare << endl;
+    cout << "Meal Preference: " << mealPreferenceNames[booking.mealPreference] << endl;
+
+    cout << "\n Cancellation Probability: " << fixed << setprecision(1) 
+         << probability << "%" << endl;
+
+    cout << "\nRisk Level: ";
+    if (probability < 20) {
+        cout << "🟢 VERY LOW (Highly likely to travel)\n";
+    } else if (probability < 40) {
+        cout << "🟡 LOW (Likely to travel)\n";
+    } else if (probability < 60) {
+        cout << "🟠 MEDIUM (Moderate cancellation risk)\n";
+    } else if (probability < 80) {
+        cout << "🔴 HIGH (Consider cancellation)\n";
+    } else {
+        cout << "🔴🔴 VERY HIGH (Very likely to cancel)\n";
+    }
+
+    // Suggestions
+    cout << "\n💡 Recommendations:\n";
+    if (probability > 50) {
+        cout << "1. Consider flexible ticket options\n";
+        cout << "2. Set cancellation reminders\n";
+        cout << "3. Check refund policy (usually 50-90% refund)\n";
+        cout << "4. Consider travel insurance\n";
+        cout << "5. Monitor train status regularly\n";
+    } else {
+        cout << "1. You're likely to travel - prepare for journey\n";
+        cout << "2. Arrive at station 1 hour before departure\n";
+        cout << "3. Keep PNR and ID proof handy\n";
+        cout << "4. Check platform number before boarding\n";
+    }
+
+    // Show confidence factors
+    cout << "\n📈 Key Factors Considered:\n";
+    cout << "- Group size: " << booking.passengers.size() << " passengers\n";
+    cout << "- Total fare: Rs." << fixed << setprecision(2) << booking.fare << endl;
+    cout << "- Meal preference: " << (booking.mealPreference != MEAL_PREF_NONE ? "Set" : "Not set") << endl;
+    cout << "- Travel date: " << booking.date << endl;
+    if (booking.bookedDay) {
+        cout << "- Booked " << dayNumber(booking.date) - booking.bookedDay << " day(s) ahead\n";
+    }
+    cout << "- Model learned from " << forecast.outcomesLearned << " past booking outcome(s)\n";
+}
+
+// ==================== MAIN MENU ====================
+
+void adminMenu() {
+    int choice;
+    do {
+        cout << "\n=== ADMIN MENU ===\n";
+        cout << "1. Add New Train\n";
+        cout << "2. View All Trains\n";
+        cout << "3. Update Catering Inventory\n";
+        cout << "4. View All Bookings\n";
+        cout << "5. Reset Catering Menu\n";
+        cout << "6. View System Stats\n";
+        cout << "7. Bulk Import Bookings\n";
+        cout << "8. Pantry Loading Report\n";
+        cout << "9. Catering Sales\n";
+        cout << "10. Back to Main Menu\n";
+        cout << "Choice: ";
+
+        string choiceStr;
+        getline(cin, choiceStr);
+
+        if (!isNumber(choiceStr)) {
+            cout << "Invalid choice! Please enter a number.\n";
+            continue;
+        }
+
+        choice = stoi(choiceStr);
+
+        switch(choice) {
+            case 1: adminAddTrain(); break;
+            case 2: adminViewTrains(); break;
+            case 3: updateInventory(); break;
+            case 4: {
+                cout << "\n=== ALL BOOKINGS ===\n";
+                bool listed = false;
+                size_t total = forEachReportBooking([&listed](const Booking& b) {
+                    if (!listed) {
+                        cout << left << setw(15) << "PNR" 
+                             << setw(10) << "Train ID" 
+                             << setw(20) << "Route" 
+                             << setw(12) << "Passengers" 
+                             << setw(15) << "Fare" 
+                             << setw(12) << "Status" 
+                             << endl;
+                        cout << string(84, '-') << endl;
+                        listed = true;
+                    }
+                    string route = b.source + "-" + b.destination;
+                    cout << left << setw(15) << formatPnr(b.pnr) 
+                         << setw(10) << b.trainId 
+                         << setw(20) << route 
+                         << setw(12) << b.passengers.size() 
+                         << "Rs." << setw(12) << fixed << setprecision(2) << b.fare 
+                         << setw(12) << formatBookingStatus(b.status) 
+                         << endl;
+                });
+                if (total == 0) {
+                    cout << "No bookings yet.\n";
+                } else {
+                    cout << "\nTotal bookings: " << total << endl;
+                }
+                break;
+            }
+            case 5: {
+                string error;
+                if (!resetCateringMenu(error)) {
+                    cout << "Error: " << error << "!\n";
+                    break;
+                }
+                cout << "✅ Catering menu reset to default.\n";
+                break;
+            }
+            case 6:
+                cout << "\n=== SYSTEM STATISTICS ===\n";
+                cout << "Trains in system: " << trains.size() << endl;
+                cout << "Total bookings: " << bookingCount() << endl;
+                cout << "Catering items: " << cateringMenu.size() << endl;
+                printEngineStats();
+                {
+                    printMemoryUsage();
+
+                    cout << "\nDump memory usage to file? (y/n): ";
+                    string memoryChoice;
+                    getline(cin, memoryChoice);
+                    if (memoryChoice == "y" || memoryChoice == "Y") {
+                        if (dumpMemoryUsage("memory_stats.json")) {
+                            cout << "✅ Memory usage written to memory_stats.json\n";
+                        } else {
+                            cout << "Error: Could not write memory_stats.json\n";
+                        }
+                    }
+                }
+                {
+                    cout << "\nDump latency histograms to file? (y/n): ";
+                    string dumpChoice;
+                    getline(cin, dumpChoice);
+                    if (dumpChoice == "y" || dumpChoice == "Y") {
+                        if (dumpLatencyHistograms("latency_histograms.txt")) {
+                            cout << "✅ Histograms written to latency_histograms.txt\n";
+                        } else {
+                            cout << "Error: Could not write latency_histograms.txt\n";
+                        }
+                    }
+                }
+                break;
+            case 7: adminBulkImport(); break;
+            case 8: adminPantryLoadingReport(); break;
+            case 9: adminCateringSales(); break;
+            case 10: break;
+            default: cout << "Invalid choice!\n";
+        }
+    } while (choice != 10);
+}
+
+void passengerMenu() {
+    int choice;
+    do {
+        cout << "\n=== PASSENGER MENU ===\n";
+        cout << "1. Book Ticket\n";
+        cout << "2. View Reservation\n";
+        cout << "3. Suggest Cheaper Routes\n";
+        cout << "4. View Catering Menu\n";
+        cout << "5. Order Catering\n";
+        cout << "6. Check Cancellation Probability\n";
+        cout << "7. Check Seat Availability\n";
+        cout << "8. Cancel Ticket\n";
+        cout << "9. Find My Bookings\n";
+        cout << "10. Back to Main Menu\n";
+        cout << "Choice: ";
+
+        string choiceStr;
+        getline(cin, choiceStr);
+
+        if (!isNumber(choiceStr)) {
+            cout << "Invalid choice! Please enter a number.\n";
+            continue;
+        }
+
+        choice = stoi(choiceStr);
+
+        switch(choice) {
+            case 1: passengerBookTicket(); break;
+            case 2: passengerViewReservations(); break;
+            case 3: suggestCheaperRoutes(); break;
+            case 4: viewCateringMenu(); break;
+            case 5: orderCatering(); break;
+            case 6: viewCancellationPrediction(); break;
+            case 7: checkSeatAvailability(); break;
+            case 8: passengerCancelTicket(); break;
+            case 9: passengerFindBookings(); break;
+            case 10: break;
+            default: cout << "Invalid choice!\n";
+        }
+    } while (choice != 10);
+}
+
+// A standby that cannot fence its lost primary asks the operator
+bool confirmTakeover(const string& host, int port) {
+    cout << "Take over only if " << host << ":" << port << " is stopped for good. Promote this standby? (y/n): ";
+    string choice;
+    getline(cin, choice);
+    return choice == "y" || choice == "Y";
+}
+
+int main(int argc, char* argv[]) {
+    // Command-line options
+    string replayPath;
+    int replayThreads = 1;
+    double replaySpeed = 1.0;
+    int replayReaders = 0;
+    string remoteEndpoint;
+    int shardPort = 0, shardIndex = 0, shardCount = 1;
+    int routerPort = 0;
+    string shardEndpoints;
+    int splitShards = 0;
+    int replicatePort = 0;
+    string standbyEndpoint;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--trace" && i + 1 < argc) {
+            enableTracing(argv[++i]);
+        } else if (arg == "--record" && i + 1 < argc) {
+            if (!enableSessionRecording(argv[++i])) {
+                cout << "Error: Could not open session recording " << argv[i] << endl;
+            }
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc && isNumber(argv[i + 1])) {
+            replayThreads = stoi(argv[++i]);
+        } else if (arg == "--speed" && i + 1 < argc && isDouble(argv[i + 1])) {
+            replaySpeed = stod(argv[++i]);
+        } else if (arg == "--readers" && i + 1 < argc && isNumber(argv[i + 1])) {
+            replayReaders = stoi(argv[++i]);
+        } else if (arg == "--remote" && i + 1 < argc) {
+            remoteEndpoint = argv[++i];
+        } else if (arg == "--data-dir" && i + 1 < argc) {
+#ifdef RAILWAY_HAS_SOCKETS
+            if (chdir(argv[++i]) != 0) {
+                cout << "Error: Could not enter data directory " << argv[i] << endl;
+                return 1;
+            }
+#else
+            i++;
+#endif
+        } else if (arg == "--serve-shard" && i + 1 < argc && isNumber(argv[i + 1])) {
+            shardPort = stoi(argv[++i]);
+        } else if (arg == "--shard" && i + 1 < argc && isNumber(argv[i + 1])) {
+            shardIndex = stoi(argv[++i]);
+        } else if (arg == "--shards" && i + 1 < argc && isNumber(argv[i + 1])) {
+            shardCount = stoi(argv[++i]);
+        } else if (arg == "--router" && i + 1 < argc && isNumber(argv[i + 1])) {
+            routerPort = stoi(argv[++i]);
+        } else if (arg == "--shard-endpoints" && i + 1 < argc) {
+            shardEndpoints = argv[++i];
+        } else if (arg == "--split-shards" && i + 1 < argc && isNumber(argv[i + 1])) {
+            splitShards = stoi(argv[++i]);
+        } else if (arg == "--replicate" && i + 1 < argc && isNumber(argv[i + 1])) {
+            replicatePort = stoi(argv[++i]);
+        } else if (arg == "--standby" && i + 1 < argc) {
+            standbyEndpoint = argv[++i];
+        } else if (arg == "--rush" && i + 1 < argc && isNumber(argv[i + 1])) {
+            enableRushAdmission(stoul(argv[++i]));
+        }
+    }
+
+    if (shardPort > 0 || routerPort > 0 || splitShards > 0) {
+#ifdef RAILWAY_HAS_SOCKETS
+        if (splitShards > 0) {
+            // Partition the data in this directory into shard0/ .. shardN-1/
+            initializeCateringMenu();
+            loadFromFile();
+            return splitIntoShards(splitShards);
+        }
+        if (routerPort > 0) {
+            vector<ShardEndpoint> shards;
+            stringstream list(shardEndpoints);
+            string item;
+            while (getline(list, item, ',')) {
+                ShardEndpoint endpoint;
+                if (!parseEndpoint(item, endpoint.host, endpoint.port)) {
+                    cout << "Error: Invalid shard endpoint " << item << " (expected host:port)\n";
+                    return 1;
+                }
+                shards.push_back(endpoint);
+            }
+            if (shards.empty()) {
+                cout << "Error: --router needs --shard-endpoints host:port,host:port,...\n";
+                return 1;
+            }
+            return runRouter(routerPort, shards);
+        }
+        if (shardCount < 1 || shardIndex < 0 || shardIndex >= shardCount) {
+            cout << "Error: --shard must be between 0 and --shards - 1\n";
+            return 1;
+        }
+        pnrShardIndex = shardIndex;
+        pnrShardCount = shardCount;
+        if (!startEngine(standbyEndpoint, replicatePort, confirmTakeover)) return 1;
+        int status = runShardServer(shardPort);
+        stopEngine();
+        return status;
+#else
+        cout << "Error: Sharding needs POSIX sockets, which this platform does not provide.\n";
+        return 1;
+#endif
+    }
+
+    if (!replayPath.empty()) {
+        // Load generator mode: replay against in-memory state, never saved,
+        // or against a shard / router with --remote
+        if (remoteEndpoint.empty()) {
+            initializeCateringMenu();
+            loadFromFile();
+            // Publish an initial view so report readers have one from the start
+            refreshReports();
+        }
+        return runReplay(replayPath, replayThreads, replaySpeed, replayReaders, remoteEndpoint);
+    }
+
+    // Initialize data
+    cout << "=======================================\n";
+    cout << "   RAILWAY TICKET MANAGEMENT SYSTEM    \n";
+    cout << "=======================================\n";
+    cout << "Loading system data...\n";
+
+    if (!startEngine(standbyEndpoint, replicatePort, confirmTakeover)) return 1;
+
+    srand(time(0));
+
+    cout << "✅ System initialized successfully!\n";
+    cout << "Trains loaded: " << trains.size() << endl;
+    cout << "Bookings loaded: " << bookingCount() << endl;
+    cout << "Catering items: " << cateringMenu.size() << endl;
+    cout << "=======================================\n";
+
+    int mainChoice;
+    do {
+        cout << "\n=== MAIN MENU ===\n";
+        cout << "1. Admin Login\n";
+        cout << "2. Passenger Portal\n";
+        cout << "3. View System Info\n";
+        cout << "4. Exit\n";
+        cout << "Choice: ";
+
+        string choiceStr;
+        getline(cin, choiceStr);
+
+        if (!isNumber(choiceStr)) {
+            cout << "Invalid choice! Please enter a number.\n";
+            continue;
+        }
+
+        mainChoice = stoi(choiceStr);
+
+        switch(mainChoice) {
+            case 1: adminMenu(); break;
+            case 2: passengerMenu(); break;
+            case 3:
+                cout << "\n=== SYSTEM INFORMATION ===\n";
+                cout << "Railway Ticket Management System\n";
+                cout << "Version: 2.0\n";
+                cout << "Features included:\n";
+                cout << "1. Admin train management\n";
+                cout << "2. Passenger ticket booking with unique PNR\n";
+                cout << "3. Cheaper route suggestions\n";
+                cout << "4. Meal preferences & catering service\n";
+                cout << "5. Cancellation probability prediction\n";
+                cout << "6. Catering inventory management\n";
+                cout << "7. File-based data persistence\n";
+                cout << "\nCurrent stats:\n";
+                cout << "- Trains: " << trains.size() << endl;
+                cout << "- Bookings: " << bookingCount() << endl;
+                cout << "- Catering items: " << cateringMenu.size() << endl;
+                cout << "\nPress Enter to continue...";
+                cin.get();
+                break;
+            case 4: 
+                stopEngine();
+                cout << "\n✅ Data saved successfully!\n";
+                if (tracingEnabled()) {
+                    if (writeTrace()) {
+                        cout << "Trace written to " << tracePath() << endl;
+                    } else {
+                        cout << "Error: Could not write trace to " << tracePath() << endl;
+                    }
+                }
+                cout << "Thank you for using Railway Ticket System!\n";
+                cout << "Goodbye!\n";
+                break;
+            default: cout << "Invalid choice! Please enter 1-4.\n";
+        }
+    } while (mainChoice != 4);
+
+    return 0;
+}
@@ -0,0 +1,436 @@
+// Railway reservation engine: the record types and the typed API that the
+// console (console.cpp), the replay and shard servers and bulk import use.
+// The engine itself is code.cpp; build both:
+//   g++ -std=c++17 -O2 -pthread code.cpp console.cpp -o railway
+// An embedding program links code.cpp with its own front end instead.
+
+#ifndef RAILWAY_H
+#define RAILWAY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+// Sharded deployment (shard servers, router, remote replay) needs POSIX sockets
+#if defined(__unix__) || defined(__APPLE__)
+#define RAILWAY_HAS_SOCKETS 1
+#endif
+
+// ==================== RECORD TYPES ====================
+
+class Train {
+public:
+    std::string trainId;
+    std::string name;
+    std::string source;
+    std::string destination;
+    std::vector<std::string> stations;
+    std::vector<int> distances;
+    int totalSeats;
+    std::string departureTime;
+    std::string arrivalTime;
+    double farePerKm;
+
+    Train(std::string id = "", std::string n = "", std::string src = "", std::string dest = "", int seatsCount = 0) {
+        trainId = id;
+        name = n;
+        source = src;
+        destination = dest;
+        totalSeats = seatsCount;
+        farePerKm = 2.5;
+    }
+};
+
+// PNRs (14 digits, HHMMSSDDMMYYYY) and phone numbers are kept as integers
+// and gender / meal preference / booking status as enums; text forms are
+// only for I/O.
+typedef uint64_t Pnr;                   // 0 = none
+const int PNR_DIGITS = 14;
+
+enum Gender : uint8_t { GENDER_UNSPECIFIED, GENDER_MALE, GENDER_FEMALE, GENDER_OTHER };
+enum MealPreference : uint8_t { MEAL_PREF_NONE, MEAL_PREF_VEG, MEAL_PREF_NON_VEG };
+enum BookingStatus : uint8_t { BOOKING_CONFIRMED, BOOKING_WAITLISTED, BOOKING_CANCELLED };
+extern const char* mealPreferenceNames[];
+
+Pnr parsePnr(const std::string& text);
+std::string formatPnr(Pnr pnr);
+// The parse functions return false for text that would not print back the
+// same (apart from case and spacing) rather than guessing
+bool parseContact(const std::string& text, uint64_t& contact);
+std::string formatContact(uint64_t contact);
+bool parseGender(const std::string& text, Gender& gender);
+const char* formatGender(Gender gender);
+bool parseBookingStatus(const std::string& text, BookingStatus& status);
+const char* formatBookingStatus(BookingStatus status);
+
+class Passenger {
+public:
+    std::string name;
+    int age;
+    Gender gender;
+    uint64_t contact;
+
+    Passenger(std::string n = "", int a = 0, Gender g = GENDER_UNSPECIFIED, uint64_t c = 0) {
+        name = n;
+        age = a;
+        gender = g;
+        contact = c;
+    }
+};
+
+class Booking {
+public:
+    Pnr pnr;
+    std::string trainId;
+    std::string source;
+    std::string destination;
+    std::vector<Passenger> passengers;
+    std::string date;
+    int coach;
+    std::vector<int> seatNumbers;
+    BookingStatus status;
+    double fare;
+    double refund;
+    MealPreference mealPreference;
+    int bookedDay;          // Day number the booking was made; 0 if unknown
+
+    Booking(std::string tid = "", std::string src = "", std::string dest = "") {
+        pnr = 0;
+        trainId = tid;
+        source = src;
+        destination = dest;
+        coach = 0;
+        status = BOOKING_CONFIRMED;
+        fare = 0.0;
+        refund = 0.0;
+        mealPreference = MEAL_PREF_NONE;
+        bookedDay = 0;
+    }
+};
+
+class CateringItem {
+public:
+    std::string itemId;
+    std::string name;
+    std::string type;
+    double price;
+    int quantity;
+
+    CateringItem(std::string id = "", std::string n = "", std::string t = "", double p = 0.0, int q = 0) {
+        itemId = id;
+        name = n;
+        type = t;
+        price = p;
+        quantity = q;
+    }
+};
+
+// Catering item types, used to count meals per type
+enum MealType { MEAL_VEG, MEAL_NON_VEG, MEAL_BEVERAGE, MEAL_SNACK, MEAL_TYPE_COUNT };
+extern const char* mealTypeNames[MEAL_TYPE_COUNT];
+
+// Days since 1970-01-01 for a DD-MM-YYYY date, or -1 if malformed
+int dayNumber(const std::string& date);
+int todayDayNumber();
+
+// How far ahead bookings are accepted from the console
+const int BOOKING_HORIZON_DAYS = 120;
+
+// ==================== RESERVATION ENGINE API ====================
+//
+// bookTicket, cancelBooking, placeCateringOrder, addTrain and the other
+// engine calls below never prompt or print; a failure comes back in the
+// result's error field or the error argument. Callers that share the
+// engine between threads hold engineMutex around each call.
+
+const size_t MAX_PASSENGERS_PER_BOOKING = 6;
+
+struct FareTier {
+    double minOccupancy;    // Fraction of seats taken
+    double multiplier;
+    const char* name;
+};
+
+struct FareBreakdown {
+    int distance;
+    double discount;
+    int children;
+    int seniors;
+    const FareTier* tier;
+};
+
+struct BookingRequest {
+    std::string trainId;
+    std::string source;
+    std::string destination;
+    std::string date;
+    MealPreference mealPreference = MEAL_PREF_NONE;
+    std::vector<Passenger> passengers;
+    Pnr pnr = 0;                    // 0 = issue a new one
+    bool allowWaitlist = true;      // otherwise a full run refuses the booking
+    bool checkBookingWindow = true; // off when re-running a recorded booking
+};
+
+struct FareQuote {
+    bool ok = false;
+    std::string error;
+    FareBreakdown breakdown = {0, 0.0, 0, 0, nullptr};
+    double fare = 0.0;              // All passengers, after discounts
+    int seatsAvailable = 0;         // On every segment of the journey
+    int mealsAvailable = -1;        // For the meal preference; -1 if none chosen
+};
+
+struct BookingResult {
+    bool ok = false;
+    std::string error;
+    Booking booking;                // As stored: PNR, status, seats and fare
+    FareBreakdown breakdown = {0, 0.0, 0, 0, nullptr};
+};
+
+struct CateringLine {
+    std::string itemName;
+    std::string itemType;
+    int quantity;
+    double price;
+};
+
+struct BookingLookup {
+    bool ok = false;
+    std::string error;
+    Booking booking;
+    std::string seats;              // "C1-5, C1-6" style
+    std::vector<CateringLine> catering;
+    double cateringTotal = 0.0;
+};
+
+struct CateringResult {
+    bool ok = false;
+    std::string error;
+    CateringItem item;
+    int quantity = 0;
+    double amount = 0.0;            // This order
+    double bill = 0.0;              // Everything ordered on the booking
+};
+
+struct AddTrainResult {
+    bool ok = false;
+    std::string error;
+    int totalDistance = 0;
+};
+
+struct CancellationForecast {
+    bool ok = false;
+    std::string error;
+    Booking booking;
+    double probability = 0.0;       // Percent
+    uint64_t outcomesLearned = 0;   // Behind the model that made the forecast
+};
+
+// Empty if the request can be booked as far as train, stations, date and
+// group size go; otherwise the reason it cannot
+std::string validateBookingRequest(const BookingRequest& request, Train*& train);
+
+// Fare, seats and meals for a booking without making it
+FareQuote quoteBooking(const BookingRequest& request);
+
+// Price, seat and record a booking. With a batch the journal record is
+// queued there for one group commit.
+BookingResult bookTicket(const BookingRequest& request,
+                         std::vector<std::pair<std::string, std::string>>* journalBatch = nullptr);
+
+BookingLookup lookupBooking(const std::string& pnr);
+// Empty if catering can be ordered on the booking (confirmed, not yet
+// travelled); otherwise the reason it cannot
+std::string validateCateringBooking(const Booking& booking);
+CateringResult placeCateringOrder(const std::string& pnr, const std::string& itemId, int quantity);
+
+// Cancel the booking in this slot, refunding its catering orders, and
+// confirm the waitlisted bookings that fit the freed seats; promoted is
+// set to how many were confirmed
+bool cancelBooking(size_t index, double& refund, std::string& error, int* promoted = nullptr);
+
+std::string validateTrain(const Train& train);
+AddTrainResult addTrain(const Train& train);
+
+// Percent chance the booking is cancelled, from the online model
+double predictCancellationProbability(const Booking& booking);
+CancellationForecast predictCancellation(const std::string& pnr);
+
+// Set an item's pantry stock / restore the default menu and stock, journaled
+bool setPantryQuantity(const std::string& itemId, int quantity, std::string& error);
+bool resetCateringMenu(std::string& error);
+
+// ==================== QUERIES ====================
+
+// Engine tables, read by front ends between API calls on the engine thread
+extern std::vector<Train> trains;
+extern std::vector<CateringItem> cateringMenu;
+extern std::map<std::string, int> pantryInventory;
+extern int pantryByType[MEAL_TYPE_COUNT];
+
+Train* findTrain(const std::string& trainId);
+CateringItem* findCateringItem(const std::string& itemId);
+
+size_t bookingCount();
+Booking bookingAt(size_t slot);
+long findBookingIndex(const std::string& pnr);
+std::vector<size_t> findBookingsByContact(const std::string& contact);
+std::vector<size_t> findBookingsByName(const std::string& name);
+
+std::string formatSeats(const Booking& booking, const Train* train);
+int seatCapacity(const Train& train);
+int availableSeatsBetween(const std::string& trainId, const std::string& date,
+                          const std::string& from, const std::string& to);
+Pnr generateUniquePNR(const std::string& travelDate);
+
+struct RouteOption {
+    double fare;
+    int distance;
+    size_t trainIndex;   // Position in the trains vector
+};
+
+std::vector<RouteOption> quoteRoutes(const std::string& source, const std::string& dest, const std::string& date);
+
+// Station names: source, stops, destination in order; the known spelling of
+// a name ("" if unknown); and close matches for misspelt or partial input
+std::vector<std::string> stationsOnRoute(const Train& train);
+std::string resolveStation(const std::string& input);
+std::vector<std::string> stationCandidates(const std::string& input, const std::vector<std::string>* allowed);
+
+// Latest published report view (never takes the engine lock to read)
+std::shared_ptr<const std::vector<Train>> reportTrains();
+size_t forEachReportBooking(const std::function<void(const Booking&)>& visit);
+
+// Meals to load per upcoming run (booked preferences plus catering orders
+// of confirmed passengers), by date then train
+struct PantryLoad {
+    std::string trainId;
+    std::string date;
+    int meals[MEAL_TYPE_COUNT];
+};
+
+std::vector<PantryLoad> pantryLoadingPlan();
+
+// Units sold and revenue per menu slot; returns the number of ledger lines
+size_t tallyCateringSales(std::vector<int>& sold, std::vector<double>& revenue);
+
+// Bulk import of travel-agent group bookings from CSV
+struct ImportRowResult {
+    int line;
+    std::string group;
+    std::string status;     // "Booked", "Rejected"
+    std::string pnr;
+    std::string message;
+};
+
+struct ImportSummary {
+    int groupsBooked;
+    int groupsRejected;
+    int passengers;
+    double totalFare;
+};
+
+ImportSummary importBookingsCsv(const std::string& path, std::vector<ImportRowResult>& results);
+bool writeImportReport(const std::string& path, const std::vector<ImportRowResult>& results);
+
+// ==================== INSTRUMENTATION ====================
+
+enum OperationType {
+    OP_BOOKING,
+    OP_PNR_LOOKUP,
+    OP_ROUTE_SEARCH,
+    OP_CATERING_ORDER,
+    OP_SAVE,
+    OP_LOAD,
+    OP_COUNT
+};
+
+// Accumulates only the working stretches of an interactive operation, so
+// time spent waiting at a prompt is not counted as latency.
+class OperationTimer {
+public:
+    OperationTimer(OperationType operation);
+    void pause();
+    void resume();
+    void finish();
+
+private:
+    OperationType op;
+    uint64_t elapsed;
+    uint64_t start;
+    bool running;
+};
+
+// Records the lifetime of a scope as a trace span when tracing is on
+class TraceSpan {
+public:
+    TraceSpan(const char* spanName);
+    ~TraceSpan();
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+void enableTracing(const std::string& path);
+bool tracingEnabled();
+bool writeTrace();
+std::string tracePath();
+
+// Session recording for --replay: BOOK, PNR, CATER, ROUTE, CANCEL
+bool enableSessionRecording(const std::string& path);
+void recordSession(const std::string& operation, const std::vector<std::string>& fields);
+void recordSessionBooking(const Booking& booking);
+
+// Runs, caches, journal, replication and latency figures for the stats page
+void printEngineStats();
+void printMemoryUsage();
+bool dumpMemoryUsage(const std::string& filename);
+bool dumpLatencyHistograms(const std::string& filename);
+
+// ==================== ENGINE LIFECYCLE ====================
+
+bool isNumber(const std::string& str);
+bool isDouble(const std::string& str);
+
+extern int pnrShardIndex;
+extern int pnrShardCount;
+
+// Asked when a standby cannot reach its primary to fence it; true takes over
+typedef std::function<bool(const std::string& host, int port)> TakeoverConfirmation;
+
+// Load the data files (or follow a primary until it goes away) and open
+// the journal; ship the journal to standbys when replicatePort is set
+bool startEngine(const std::string& standbyEndpoint, int replicatePort,
+                 const TakeoverConfirmation& confirmTakeover = nullptr);
+void stopEngine();
+
+// Load without opening the journal (replay and shard splitting)
+void initializeCateringMenu();
+uint64_t loadFromFile();
+void refreshReports();
+
+void enableRushAdmission(size_t limit);
+
+int runReplay(const std::string& path, int threadCount, double speed, int readerCount = 0,
+              const std::string& remote = "");
+
+struct ShardEndpoint {
+    std::string host;
+    int port;
+};
+
+bool parseEndpoint(const std::string& text, std::string& host, int& port);
+
+#ifdef RAILWAY_HAS_SOCKETS
+int runShardServer(int port);
+int runRouter(int port, const std::vector<ShardEndpoint>& shards);
+int splitIntoShards(int shardCount);
+#endif
+
+#endif